@@ -5,6 +5,11 @@
     In the C++ interface the returned string is allocated in C it's either the
     internal stack buffer or a provided one
 
+    All functions are reentrant, the internal buffer used when buffer == NULL is shared
+    unless HASH_THREAD_LOCAL_BUFFERS is 1, so pass your own buffer when hashing from multiple threads.
+    The exception is HASH_SHA2_ESP32_HARDWARE (off by default): the esp32 sha engine is reserved from init
+    until finalize, a hash started meanwhile runs in software and one that isn't finalized keeps the engine
+
     C interface:
     all functions start with hash_ and structs with Hash_ private classes start with Hash_Private_
     hash_private_ functions are for the implementation and should not be called
@@ -18,7 +23,13 @@
 
         hash_sha256_binary("Hello world", 11, buffer); // the binary function take the size of the string e.g. for binary files
 
-    or if you need to update the hash e.g. while reading chunks from a file (not supported for SHA3, Shake128 and Shake256
+        hash_sha512_batch(messages, sizes, count, digests); // many independent messages at once, count * 64 raw digest bytes
+
+        Hash_Hmac_Sha256 key;
+        hash_hmac_sha256_init(key, "secret", 6); // computes the pads once
+        hash_hmac_sha256_binary(key, "Hello world", 11, mac); // raw 32 byte mac, compare with hash_util_digest_equal
+
+    or if you need to update the hash e.g. while reading chunks from a file
 
         Hash_Sha256 s;
         hash_sha256_init(s);
@@ -26,6 +37,12 @@
         hash_sha256_finalize(s);
         const char* hash = hash_sha256_hexdigest(s, buffer);
 
+        Hash_Sha3 s; hash_sha3_256_init(s); // sha3 shares one context type, init selects the size
+        Hash_Shake s; hash_shake128_init(s); // shake output is squeezed on demand with hash_shake_squeeze/hash_shake_hexsqueeze
+
+    the file functions stream the file through the update functions, with HASH_FILE_MMAP
+    the file is memory mapped, a file that gets truncated while being hashed raises SIGBUS then
+
     C++ interface:
     all functions and classes are in the namespace Hash
     either use the provided functions, all have the same scheme:
@@ -33,21 +50,75 @@
         Hash::sha256("Hello world"); // returns std::string
         Hash::File::sha256("main.c", std::ios::binary);
 
-    or if you need to update the hash e.g. while reading chunks from a file (not supported for SHA3, Shake128 and Shake256)
+        Hash::File::sha512_tree("backup.tar"); // parallel tree hash of big files, "sha512-tree:<chunk size>:<root>"
+
+        constexpr auto digest = Hash::sha512_ct("Hello world"); // std::array<uint8_t, 64> computed at compile time, also Hash::sha256_ct
+
+    or if you need to update the hash e.g. while reading chunks from a file
         Hash::Sha256 s;
         s.Update("Hello world");
         s.Finalize();
         std::string hash = s.Hexdigest();
+
+        Hash::Sha3 s(256); // 224, 256, 384, 512
+        Hash::Shake s(128); // 128, 256, then s.Squeeze(out, size) or s.Hexsqueeze(outsizeBytes) as often as needed
+
+    the options below are defaults, define any of them before including the header (or with -D) to override it
 */
+#ifndef HASH_ENABLE_MD5
 #define HASH_ENABLE_MD5    0 // md5
+#endif
+#ifndef HASH_ENABLE_SHA1
 #define HASH_ENABLE_SHA1   0 // sha1
+#endif
+#ifndef HASH_ENABLE_SHA2
 #define HASH_ENABLE_SHA2   1 // sha224, sha256, sha384, sha512, sha512/t
+#endif
+#ifndef HASH_SHA2_ESP32_HARDWARE
+#define HASH_SHA2_ESP32_HARDWARE 0 // sha224, sha256, sha384, sha512 on the esp32 sha accelerator (C interface, ignored if not compiled for the esp32), see the note on reentrancy above
+#endif
+#ifndef HASH_SHA256_CPU_EXTENSIONS
+#define HASH_SHA256_CPU_EXTENSIONS 1 // sha224, sha256 with sha-ni (x86) or the armv8 crypto extensions (arm64, compile with +crypto) if the cpu supports them
+#endif
+#ifndef HASH_SHA512_MULTI_BUFFER
+#define HASH_SHA512_MULTI_BUFFER   1 // sha512 batch functions hash 8/4/2 messages at once in avx-512/avx2/neon lanes if the cpu supports them
+#endif
+#ifndef HASH_SHA512_TREE
+#define HASH_SHA512_TREE           1 // Hash::File::sha512_tree hashes chunks of big files on all cores (C++ interface, needs std::thread)
+#endif
+#ifndef HASH_SHA512_TREE_CHUNK_SIZE
+#define HASH_SHA512_TREE_CHUNK_SIZE (16 * 1024 * 1024) // default bytes per leaf of Hash::File::sha512_tree
+#endif
+#ifndef HASH_ENABLE_KECCAK
 #define HASH_ENABLE_KECCAK 0 // sha3-224, sha3-256, sha3-384, sha3-512, shake128 and shake256
+#endif
+#ifndef HASH_ENABLE_C_INTERFACE
 #define HASH_ENABLE_C_INTERFACE   1
+#endif
+#ifndef HASH_ENABLE_CPP_INTERFACE
 #define HASH_ENABLE_CPP_INTERFACE 0
+#endif
+#ifndef HASH_KECCAK_LITTLE_ENDIAN
 #define HASH_KECCAK_LITTLE_ENDIAN 1 // true for most systems (windows, linux, macos)
+#endif
+#ifndef HASH_KECCAK_UNROLLED
+#define HASH_KECCAK_UNROLLED      1 // unrolled keccak permutation, bit interleaved on 32 bit cpus (esp32), 0 uses the compact reference code
+#endif
+#ifndef HASH_SHAKE_128_MALLOC_LIMIT
 #define HASH_SHAKE_128_MALLOC_LIMIT 64 // if outsizeBytes is greater and no buffer is provided we will heap allocate
+#endif
+#ifndef HASH_SHAKE_256_MALLOC_LIMIT
 #define HASH_SHAKE_256_MALLOC_LIMIT 64 // if outsizeBytes is greater and no buffer is provided we will heap allocate
+#endif
+#ifndef HASH_THREAD_LOCAL_BUFFERS
+#define HASH_THREAD_LOCAL_BUFFERS   0  // if 1 the internal buffers returned when buffer == NULL are thread local instead of shared
+#endif
+#ifndef HASH_FILE_CHUNK_SIZE
+#define HASH_FILE_CHUNK_SIZE     4096 // bytes the file functions read at once (stack buffer)
+#endif
+#ifndef HASH_FILE_MMAP
+#define HASH_FILE_MMAP           1    // the file functions memory map binary files on windows and posix systems instead of reading chunks
+#endif
 
 #ifdef _MSC_VER
 #pragma warning( push )
@@ -59,7 +130,9 @@
 
 
 #if defined(__cplusplus) && HASH_ENABLE_CPP_INTERFACE == 1
+#include <array>
 #include <string>
+#include <algorithm>
 #include <locale>
 #include <cstdio>
 #include <limits>
@@ -74,6 +147,11 @@
 #include <cinttypes>
 #include <type_traits>
 #include <string_view>
+#if HASH_ENABLE_SHA2 == 1 && HASH_SHA512_TREE == 1
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
 #define HASH_INLINE inline
 #else
 #include <stdio.h>
@@ -86,19 +164,595 @@
 #define HASH_INLINE static
 #endif // __cplusplus && HASH_ENABLE_CPP_INTERFACE
 
-#if HASH_ENABLE_C_INTERFACE == 1
-// ================================Util====================================
-HASH_INLINE void hash_util_char_array_to_hex_string(unsigned char* data, size_t size, char* out)
+// storage of the internal buffers that get returned if no buffer is provided
+#if HASH_THREAD_LOCAL_BUFFERS == 1
+#if defined(__cplusplus)
+#define HASH_INTERNAL_BUFFER static thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define HASH_INTERNAL_BUFFER static _Thread_local
+#elif defined(_MSC_VER)
+#define HASH_INTERNAL_BUFFER static __declspec(thread)
+#else
+#define HASH_INTERNAL_BUFFER static __thread
+#endif
+#else
+#define HASH_INTERNAL_BUFFER static
+#endif // HASH_THREAD_LOCAL_BUFFERS
+
+// the accelerator is used through mbedtls, it falls back to software if the engine is busy
+#if HASH_ENABLE_SHA2 == 1 && HASH_SHA2_ESP32_HARDWARE == 1 && defined(ESP_PLATFORM)
+#define HASH_PRIVATE_SHA2_ESP32 1
+#include "mbedtls/version.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define HASH_PRIVATE_MBEDTLS(func) func
+#else
+#define HASH_PRIVATE_MBEDTLS(func) func##_ret
+#endif
+#else
+#define HASH_PRIVATE_SHA2_ESP32 0
+#endif
+
+#if HASH_ENABLE_SHA2 == 1 && (HASH_SHA256_CPU_EXTENSIONS == 1 || HASH_SHA512_MULTI_BUFFER == 1) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define HASH_PRIVATE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define HASH_PRIVATE_TARGET(isa)
+#else
+#include <cpuid.h>
+#define HASH_PRIVATE_TARGET(isa) __attribute__((target(isa)))
+#endif
+#else
+#define HASH_PRIVATE_X86 0
+#endif
+
+#if HASH_ENABLE_SHA2 == 1 && (HASH_SHA256_CPU_EXTENSIONS == 1 || HASH_SHA512_MULTI_BUFFER == 1) && defined(__aarch64__)
+#define HASH_PRIVATE_ARM64 1
+#include <arm_neon.h>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#else
+#define HASH_PRIVATE_ARM64 0
+#endif
+
+// the file functions map the file if the os supports it and read it in chunks otherwise
+#if HASH_FILE_MMAP == 1 && defined(_WIN32)
+#define HASH_PRIVATE_MMAP 1
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define HASH_PRIVATE_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define HASH_PRIVATE_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef HASH_PRIVATE_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef HASH_PRIVATE_LEAN_AND_MEAN
+#endif
+#ifdef HASH_PRIVATE_NOMINMAX
+#undef NOMINMAX
+#undef HASH_PRIVATE_NOMINMAX
+#endif
+#elif HASH_FILE_MMAP == 1 && (defined(__unix__) || defined(__APPLE__))
+#define HASH_PRIVATE_MMAP 2
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define HASH_PRIVATE_MMAP 0
+#endif
+
+#if HASH_SHA256_CPU_EXTENSIONS == 1 && (HASH_PRIVATE_X86 == 1 || (HASH_PRIVATE_ARM64 == 1 && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))))
+#define HASH_PRIVATE_SHA256_ACCEL 1
+#else
+#define HASH_PRIVATE_SHA256_ACCEL 0
+#endif
+
+
+#if HASH_PRIVATE_X86 == 1
+// ================================Hash_Cpu=====================================
+#define HASH_PRIVATE_X86_SHA    1
+#define HASH_PRIVATE_X86_AVX2   2
+#define HASH_PRIVATE_X86_AVX512 4
+
+// extensions supported by the cpu and enabled by the os, detected once
+HASH_INLINE int hash_private_x86_features()
 {
-    static const char hex_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
-    size_t k = 0;
-    for (size_t i = 0; i < size; ++i)
+    static int cached = -1; // racing threads all store the same value
+    if (cached == -1)
+    {
+        unsigned int r1[4] = { 0 }, r7[4] = { 0 };
+        uint64_t xcr0 = 0;
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 0);
+        const int maxLeaf = regs[0];
+        __cpuid(regs, 1);
+        memcpy(r1, regs, sizeof(r1));
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(regs, 7, 0);
+            memcpy(r7, regs, sizeof(r7));
+        }
+        if ((r1[2] >> 27) & 1) // osxsave
+            xcr0 = _xgetbv(0);
+#else
+        __get_cpuid(1, &r1[0], &r1[1], &r1[2], &r1[3]);
+        __get_cpuid_count(7, 0, &r7[0], &r7[1], &r7[2], &r7[3]);
+        if ((r1[2] >> 27) & 1) // osxsave
+        {
+            unsigned int lo, hi;
+            __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            xcr0 = ((uint64_t)hi << 32) | lo;
+        }
+#endif
+        int features = 0;
+        if (((r1[2] >> 19) & 1) && ((r7[1] >> 29) & 1)) // sse4.1 and sha
+            features |= HASH_PRIVATE_X86_SHA;
+        if ((xcr0 & 0x06) == 0x06 && ((r7[1] >> 5) & 1)) // ymm state and avx2
+            features |= HASH_PRIVATE_X86_AVX2;
+        if ((xcr0 & 0xE6) == 0xE6 && ((r7[1] >> 16) & 1)) // zmm state and avx512f
+            features |= HASH_PRIVATE_X86_AVX512;
+        cached = features;
+    }
+    return cached;
+}
+// ================================Hash_Cpu=====================================
+#endif // HASH_PRIVATE_X86
+
+
+#if HASH_PRIVATE_SHA256_ACCEL == 1
+// ============================Hash_Sha256_Accel================================
+// shared by the C and C++ interface, selected at runtime if the cpu supports it
+static const uint32_t hash_private_sha256_accel_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#if defined(__aarch64__)
+HASH_INLINE int hash_private_sha256_accel_supported()
+{
+#ifdef __linux__
+    static int cached = -1; // racing threads all store the same value
+    if (cached == -1)
+        cached = (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+    return cached;
+#else
+    return 1; // compiled with the crypto extensions
+#endif
+}
+
+// ARMv8 sha256h/sha256h2/sha256su0/sha256su1, 4 rounds per iteration
+HASH_INLINE void hash_private_sha256_accel_transform(uint32_t* h, const uint8_t* block)
+{
+    uint32x4_t abcd = vld1q_u32(&h[0]);
+    uint32x4_t efgh = vld1q_u32(&h[4]);
+    const uint32x4_t abcdSave = abcd;
+    const uint32x4_t efghSave = efgh;
+
+    uint32x4_t m[4];
+    for (size_t i = 0; i < 4; ++i)
+        m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&block[16 * i])));
+
+    for (size_t r = 0; r < 16; ++r)
+    {
+        const uint32x4_t wk = vaddq_u32(m[r & 3], vld1q_u32(&hash_private_sha256_accel_k[4 * r]));
+        if (r < 12) // schedule the words for round r + 4
+            m[r & 3] = vsha256su1q_u32(vsha256su0q_u32(m[r & 3], m[(r + 1) & 3]), m[(r + 2) & 3], m[(r + 3) & 3]);
+
+        const uint32x4_t abcdPrev = abcd;
+        abcd = vsha256hq_u32(abcd, efgh, wk);
+        efgh = vsha256h2q_u32(efgh, abcdPrev, wk);
+    }
+
+    vst1q_u32(&h[0], vaddq_u32(abcd, abcdSave));
+    vst1q_u32(&h[4], vaddq_u32(efgh, efghSave));
+}
+#else
+HASH_INLINE int hash_private_sha256_accel_supported()
+{
+    return (hash_private_x86_features() & HASH_PRIVATE_X86_SHA) != 0;
+}
+
+// SHA-NI sha256rnds2/sha256msg1/sha256msg2, 4 rounds per iteration
+HASH_PRIVATE_TARGET("sha,sse4.1") HASH_INLINE void hash_private_sha256_accel_transform(uint32_t* h, const uint8_t* block)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // sha256rnds2 works on the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[0]), 0xB1); // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[4]), 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+    const __m128i abefSave = state0;
+    const __m128i cdghSave = state1;
+
+    __m128i m[4];
+    for (size_t i = 0; i < 4; ++i)
+        m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&block[16 * i]), mask);
+
+    for (size_t r = 0; r < 16; ++r)
+    {
+        const __m128i wk = _mm_add_epi32(m[r & 3], _mm_loadu_si128((const __m128i*)&hash_private_sha256_accel_k[4 * r]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+
+        if (r < 12) // schedule the words for round r + 4
+        {
+            const __m128i t = _mm_add_epi32(_mm_sha256msg1_epu32(m[r & 3], m[(r + 1) & 3]), _mm_alignr_epi8(m[(r + 3) & 3], m[(r + 2) & 3], 4));
+            m[r & 3] = _mm_sha256msg2_epu32(t, m[(r + 3) & 3]);
+        }
+    }
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+    _mm_storeu_si128((__m128i*)&h[0], _mm_blend_epi16(tmp, state1, 0xF0)); // DCBA
+    _mm_storeu_si128((__m128i*)&h[4], _mm_alignr_epi8(state1, tmp, 8)); // HGFE
+}
+#endif // __aarch64__
+// ============================Hash_Sha256_Accel================================
+#endif // HASH_PRIVATE_SHA256_ACCEL
+
+
+#if HASH_ENABLE_SHA2 == 1
+// =========================Hash_Sha512_MultiBuffer=============================
+// shared by the C and C++ interface, hashes up to `lanes` independent messages in lockstep
+static const uint64_t hash_private_sha512_mb_k[80] =
+{
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538,
+    0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe,
+    0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2, 0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
+    0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+    0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5, 0x983e5152ee66dfab,
+    0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
+    0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed,
+    0x53380d139d95b3df, 0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+    0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
+    0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8, 0x19a4c116b8d2d0c8, 0x1e376c085141ab53,
+    0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373,
+    0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c,
+    0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6,
+    0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
+    0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+};
+
+static const uint64_t hash_private_sha512_mb_iv[8] =
+{
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+    0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179
+};
+
+// number of 128 byte blocks of the padded message
+HASH_INLINE size_t hash_private_sha512_mb_blocks(size_t size)
+{
+    return (size + 1 + 16 + 127) / 128;
+}
+
+// writes the 16 message words of block b to words[i * stride] and pads the last blocks on the fly
+HASH_INLINE void hash_private_sha512_mb_load(uint64_t* words, size_t stride, const uint8_t* data, size_t size, size_t b)
+{
+    // data + offset is only formed inside the message, data may be null for an empty one
+    uint8_t pad[128];
+    const uint8_t* block;
+    const size_t offset = b * 128;
+    if (offset + 128 <= size)
+        block = data + offset;
+    else
+    {
+        memset(pad, 0, sizeof(pad));
+        if (offset < size)
+            memcpy(pad, data + offset, size - offset);
+        if (offset <= size)
+            pad[size - offset] = 0x80;
+        if (b + 1 == hash_private_sha512_mb_blocks(size))
+        {
+            const uint64_t bitlen = (uint64_t)size * 8;
+            for (size_t k = 0; k < 8; ++k)
+                pad[120 + k] = (uint8_t)(bitlen >> (56 - 8 * k));
+        }
+        block = pad;
+    }
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        uint64_t w = 0;
+        for (size_t k = 0; k < 8; ++k)
+            w = (w << 8) | block[8 * i + k];
+        words[i * stride] = w;
+    }
+}
+
+// generates a kernel for `lanes` messages, vec holds one 64 bit word per lane
+#define HASH_PRIVATE_SHA512_MB_DEFINE(name, lanes, target, vec, LOAD, STORE, SET1, ADD, XOR, AND, ANDNOT, SHR, ROR) \
+    target HASH_INLINE void name(const char* const* data, const size_t* sizes, size_t count, uint8_t* digests) \
+    { \
+        uint64_t state[8][lanes], next[8][lanes], words[16][lanes]; \
+        size_t blocks[lanes], maxBlocks = 0; \
+        for (size_t l = 0; l < lanes; ++l) \
+        { \
+            blocks[l] = l < count ? hash_private_sha512_mb_blocks(sizes[l]) : 0; \
+            maxBlocks = blocks[l] > maxBlocks ? blocks[l] : maxBlocks; \
+            for (size_t i = 0; i < 8; ++i) \
+                state[i][l] = hash_private_sha512_mb_iv[i]; \
+        } \
+ \
+        memset(words, 0, sizeof(words)); \
+        for (size_t b = 0; b < maxBlocks; ++b) \
+        { \
+            for (size_t l = 0; l < lanes; ++l) \
+            { \
+                if (b < blocks[l]) \
+                    hash_private_sha512_mb_load(&words[0][l], lanes, (const uint8_t*)data[l], sizes[l], b); \
+            } \
+ \
+            vec w[80]; \
+            for (size_t i = 0; i < 16; ++i) \
+                w[i] = LOAD(words[i]); \
+            for (size_t i = 16; i < 80; ++i) \
+            { \
+                const vec s0 = XOR(XOR(ROR(w[i - 15], 1), ROR(w[i - 15], 8)), SHR(w[i - 15], 7)); \
+                const vec s1 = XOR(XOR(ROR(w[i - 2], 19), ROR(w[i - 2], 61)), SHR(w[i - 2], 6)); \
+                w[i] = ADD(ADD(w[i - 16], s0), ADD(w[i - 7], s1)); \
+            } \
+ \
+            vec a = LOAD(state[0]), b_ = LOAD(state[1]), c = LOAD(state[2]), d = LOAD(state[3]); \
+            vec e = LOAD(state[4]), f = LOAD(state[5]), g = LOAD(state[6]), h = LOAD(state[7]); \
+            for (size_t i = 0; i < 80; ++i) \
+            { \
+                const vec s1 = XOR(XOR(ROR(e, 14), ROR(e, 18)), ROR(e, 41)); \
+                const vec ch = XOR(AND(e, f), ANDNOT(e, g)); \
+                const vec temp1 = ADD(ADD(ADD(h, s1), ADD(ch, SET1(hash_private_sha512_mb_k[i]))), w[i]); \
+                const vec s0 = XOR(XOR(ROR(a, 28), ROR(a, 34)), ROR(a, 39)); \
+                const vec maj = XOR(XOR(AND(a, b_), AND(a, c)), AND(b_, c)); \
+                const vec temp2 = ADD(s0, maj); \
+                h = g; \
+                g = f; \
+                f = e; \
+                e = ADD(d, temp1); \
+                d = c; \
+                c = b_; \
+                b_ = a; \
+                a = ADD(temp1, temp2); \
+            } \
+            STORE(next[0], ADD(a, LOAD(state[0]))); \
+            STORE(next[1], ADD(b_, LOAD(state[1]))); \
+            STORE(next[2], ADD(c, LOAD(state[2]))); \
+            STORE(next[3], ADD(d, LOAD(state[3]))); \
+            STORE(next[4], ADD(e, LOAD(state[4]))); \
+            STORE(next[5], ADD(f, LOAD(state[5]))); \
+            STORE(next[6], ADD(g, LOAD(state[6]))); \
+            STORE(next[7], ADD(h, LOAD(state[7]))); \
+ \
+            for (size_t l = 0; l < lanes; ++l) /* finished lanes keep their state */ \
+            { \
+                if (b < blocks[l]) \
+                { \
+                    for (size_t i = 0; i < 8; ++i) \
+                        state[i][l] = next[i][l]; \
+                } \
+            } \
+        } \
+ \
+        for (size_t l = 0; l < count; ++l) \
+        { \
+            for (size_t i = 0; i < 64; ++i) \
+                digests[64 * l + i] = (uint8_t)(state[i / 8][l] >> (56 - 8 * (i % 8))); \
+        } \
+    }
+
+#define HASH_PRIVATE_SHA512_MB_SCALAR_LOAD(p)         (*(p))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_STORE(p, v)     (*(p) = (v))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_SET1(x)         (x)
+#define HASH_PRIVATE_SHA512_MB_SCALAR_ADD(x, y)       ((x) + (y))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_XOR(x, y)       ((x) ^ (y))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_AND(x, y)       ((x) & (y))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_ANDNOT(x, y)    (~(x) & (y))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_SHR(x, n)       ((x) >> (n))
+#define HASH_PRIVATE_SHA512_MB_SCALAR_ROR(x, n)       (((x) >> (n)) | ((x) << (64 - (n))))
+HASH_PRIVATE_SHA512_MB_DEFINE(hash_private_sha512_mb_x1, 1, , uint64_t,
+    HASH_PRIVATE_SHA512_MB_SCALAR_LOAD, HASH_PRIVATE_SHA512_MB_SCALAR_STORE, HASH_PRIVATE_SHA512_MB_SCALAR_SET1,
+    HASH_PRIVATE_SHA512_MB_SCALAR_ADD, HASH_PRIVATE_SHA512_MB_SCALAR_XOR, HASH_PRIVATE_SHA512_MB_SCALAR_AND,
+    HASH_PRIVATE_SHA512_MB_SCALAR_ANDNOT, HASH_PRIVATE_SHA512_MB_SCALAR_SHR, HASH_PRIVATE_SHA512_MB_SCALAR_ROR)
+
+#if HASH_SHA512_MULTI_BUFFER == 1 && HASH_PRIVATE_X86 == 1
+#define HASH_PRIVATE_SHA512_MB_AVX2_LOAD(p)           _mm256_loadu_si256((const __m256i*)(p))
+#define HASH_PRIVATE_SHA512_MB_AVX2_STORE(p, v)       _mm256_storeu_si256((__m256i*)(p), v)
+#define HASH_PRIVATE_SHA512_MB_AVX2_SET1(x)           _mm256_set1_epi64x((long long)(x))
+#define HASH_PRIVATE_SHA512_MB_AVX2_SHR(x, n)         _mm256_srli_epi64(x, n)
+#define HASH_PRIVATE_SHA512_MB_AVX2_ROR(x, n)         _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+HASH_PRIVATE_SHA512_MB_DEFINE(hash_private_sha512_mb_avx2, 4, HASH_PRIVATE_TARGET("avx2"), __m256i,
+    HASH_PRIVATE_SHA512_MB_AVX2_LOAD, HASH_PRIVATE_SHA512_MB_AVX2_STORE, HASH_PRIVATE_SHA512_MB_AVX2_SET1,
+    _mm256_add_epi64, _mm256_xor_si256, _mm256_and_si256, _mm256_andnot_si256,
+    HASH_PRIVATE_SHA512_MB_AVX2_SHR, HASH_PRIVATE_SHA512_MB_AVX2_ROR)
+
+#define HASH_PRIVATE_SHA512_MB_AVX512_LOAD(p)         _mm512_loadu_si512((const void*)(p))
+#define HASH_PRIVATE_SHA512_MB_AVX512_STORE(p, v)     _mm512_storeu_si512((void*)(p), v)
+#define HASH_PRIVATE_SHA512_MB_AVX512_SET1(x)         _mm512_set1_epi64((long long)(x))
+#define HASH_PRIVATE_SHA512_MB_AVX512_ANDNOT(x, y)    _mm512_maskz_andnot_epi64(0xFF, x, y) /* the maskz forms avoid gcc 12 -Wmaybe-uninitialized noise */
+#define HASH_PRIVATE_SHA512_MB_AVX512_SHR(x, n)       _mm512_maskz_srli_epi64(0xFF, x, n)
+#define HASH_PRIVATE_SHA512_MB_AVX512_ROR(x, n)       _mm512_maskz_ror_epi64(0xFF, x, n)
+HASH_PRIVATE_SHA512_MB_DEFINE(hash_private_sha512_mb_avx512, 8, HASH_PRIVATE_TARGET("avx512f"), __m512i,
+    HASH_PRIVATE_SHA512_MB_AVX512_LOAD, HASH_PRIVATE_SHA512_MB_AVX512_STORE, HASH_PRIVATE_SHA512_MB_AVX512_SET1,
+    _mm512_add_epi64, _mm512_xor_si512, _mm512_and_si512, HASH_PRIVATE_SHA512_MB_AVX512_ANDNOT,
+    HASH_PRIVATE_SHA512_MB_AVX512_SHR, HASH_PRIVATE_SHA512_MB_AVX512_ROR)
+#endif // HASH_SHA512_MULTI_BUFFER && HASH_PRIVATE_X86
+
+#if HASH_SHA512_MULTI_BUFFER == 1 && HASH_PRIVATE_ARM64 == 1
+#define HASH_PRIVATE_SHA512_MB_NEON_ANDNOT(x, y)      vbicq_u64(y, x)
+#define HASH_PRIVATE_SHA512_MB_NEON_ROR(x, n)         vsriq_n_u64(vshlq_n_u64(x, 64 - (n)), x, n)
+HASH_PRIVATE_SHA512_MB_DEFINE(hash_private_sha512_mb_neon, 2, , uint64x2_t,
+    vld1q_u64, vst1q_u64, vdupq_n_u64, vaddq_u64, veorq_u64, vandq_u64,
+    HASH_PRIVATE_SHA512_MB_NEON_ANDNOT, vshrq_n_u64, HASH_PRIVATE_SHA512_MB_NEON_ROR)
+#endif // HASH_SHA512_MULTI_BUFFER && HASH_PRIVATE_ARM64
+
+// digests must hold 64 bytes per message, the widest available kernel is picked at runtime
+HASH_INLINE void hash_private_sha512_mb(const char* const* data, const size_t* sizes, size_t count, uint8_t* digests)
+{
+    size_t lanes = 1;
+    void (*kernel)(const char* const*, const size_t*, size_t, uint8_t*) = hash_private_sha512_mb_x1;
+#if HASH_SHA512_MULTI_BUFFER == 1 && HASH_PRIVATE_X86 == 1
+    const int features = hash_private_x86_features();
+    if (features & HASH_PRIVATE_X86_AVX512)
+    {
+        lanes = 8;
+        kernel = hash_private_sha512_mb_avx512;
+    }
+    else if (features & HASH_PRIVATE_X86_AVX2)
+    {
+        lanes = 4;
+        kernel = hash_private_sha512_mb_avx2;
+    }
+#elif HASH_SHA512_MULTI_BUFFER == 1 && HASH_PRIVATE_ARM64 == 1
+    lanes = 2;
+    kernel = hash_private_sha512_mb_neon;
+#endif
+
+    for (size_t i = 0; i < count; i += lanes)
+        kernel(&data[i], &sizes[i], count - i < lanes ? count - i : lanes, &digests[64 * i]);
+}
+// =========================Hash_Sha512_MultiBuffer=============================
+#endif // HASH_ENABLE_SHA2
+
+
+#if HASH_PRIVATE_MMAP != 0
+// ================================Hash_File====================================
+// read only view of a whole file, shared by the C and C++ interface
+#define HASH_PRIVATE_FILE_SLICE ((size_t)1 << 30) // mapped files are passed on in slices, md5 counts 32 bit lengths
+
+typedef struct
+{
+    const char* data;
+    size_t size;
+#if HASH_PRIVATE_MMAP == 1
+    HANDLE mapping;
+#endif
+} Hash_Private_File_Map;
+
+// returns 0 if the file can't be mapped (missing, empty, not a regular file, text mode on windows), read it in chunks then
+HASH_INLINE int hash_private_file_map(const char* path, int binary, Hash_Private_File_Map* map)
+{
+#if HASH_PRIVATE_MMAP == 1
+    if (!binary) return 0; // text mode translates line endings, the mapped bytes would differ
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && (unsigned long long)size.QuadPart <= (unsigned long long)SIZE_MAX)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file); // the mapping keeps the file open
+    if (mapping == NULL) return 0;
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
     {
-        char const byte = data[i];
-        out[k++] = hex_chars[(byte & 0xF0) >> 4];
-        out[k++] = hex_chars[(byte & 0x0F) >> 0];
+        CloseHandle(mapping);
+        return 0;
     }
-    out[k] = 0;
+
+    map->data = (const char*)data;
+    map->size = (size_t)size.QuadPart;
+    map->mapping = mapping;
+    return 1;
+#else
+    (void)binary; // no text mode on posix systems
+
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) return 0;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (off_t)(size_t)st.st_size == st.st_size)
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) return 0;
+
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL); // read ahead while the pages are hashed
+#endif
+    map->data = (const char*)data;
+    map->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+HASH_INLINE void hash_private_file_unmap(Hash_Private_File_Map* map)
+{
+#if HASH_PRIVATE_MMAP == 1
+    UnmapViewOfFile(map->data);
+    CloseHandle(map->mapping);
+#else
+    munmap((void*)map->data, map->size);
+#endif
+}
+// ================================Hash_File====================================
+#endif // HASH_PRIVATE_MMAP
+
+
+// =================================Hash_Hex====================================
+// a single table lookup per byte, out must hold 2 * size + 1 chars
+HASH_INLINE void hash_private_hex_encode(const unsigned char* data, size_t size, char* out)
+{
+    static const char pairs[513] =
+        "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+        "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+        "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+        "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+        "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+        "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+        "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+        "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+    for (size_t i = 0; i < size; ++i)
+        memcpy(&out[2 * i], &pairs[2 * data[i]], 2);
+    out[2 * size] = 0;
+}
+// =================================Hash_Hex====================================
+
+
+#if HASH_ENABLE_KECCAK == 1
+// ===============================Hash_Keccak===================================
+// sponge state for the incremental sha3 and shake functions, shared by the C and C++ interface
+// the functions are implemented with the permutation at the end of the file
+typedef struct
+{
+    uint64_t state[25];
+    unsigned int rateInBytes;
+    unsigned int offset; // bytes absorbed into or squeezed from the current block
+    unsigned char delimitedSuffix;
+    int squeezing;
+} Hash_Private_Keccak;
+
+HASH_INLINE void hash_private_keccak_init(Hash_Private_Keccak* k, unsigned int rate, unsigned char delimitedSuffix);
+HASH_INLINE void hash_private_keccak_absorb(Hash_Private_Keccak* k, const unsigned char* input, size_t size);
+HASH_INLINE void hash_private_keccak_finalize(Hash_Private_Keccak* k);
+HASH_INLINE void hash_private_keccak_squeeze(Hash_Private_Keccak* k, unsigned char* output, size_t size);
+// ===============================Hash_Keccak===================================
+#endif // HASH_ENABLE_KECCAK
+
+
+#if HASH_ENABLE_C_INTERFACE == 1
+// ================================Util====================================
+HASH_INLINE void hash_util_char_array_to_hex_string(const unsigned char* data, size_t size, char* out)
+{
+    hash_private_hex_encode(data, size, out);
 }
 
 HASH_INLINE char* hash_util_load_file(const char* path, const char* mode, long* fsize)
@@ -110,24 +764,61 @@ HASH_INLINE char* hash_util_load_file(const char* path, const char* mode, long*
     *fsize = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    char* string = (char*)malloc((size_t)*fsize);
-    if (string == NULL) return NULL;
-    fread(string, *fsize, 1, f);
+    if (*fsize < 0)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    char* string = (char*)malloc(*fsize != 0 ? (size_t)*fsize : 1); // malloc(0) may return NULL for empty files
+    if (string == NULL)
+    {
+        fclose(f);
+        return NULL;
+    }
+    *fsize = (long)fread(string, 1, (size_t)*fsize, f); // text mode reads fewer bytes
     fclose(f);
     return string;
 }
 
+// loads the whole file into memory and passes it to hashfunc
 HASH_INLINE const char* hash_util_hash_file(const char* path, const char* mode, const char* (*hashfunc)(const char*, size_t, char*), char* buffer)
 {
     long fsize;
     char* content = hash_util_load_file(path, mode, &fsize);
     if (content == NULL) return "";
     const char* hash = hashfunc(content, fsize, buffer);
-    if (content != NULL)
-        free(content);
+    free(content);
     return hash;
 }
 
+// calls update(s, chunk, size) for the whole file with constant memory, returns 0 if the file can't be read
+HASH_INLINE int hash_util_read_file(const char* path, const char* mode, void (*update)(void*, const char*, size_t), void* s)
+{
+#if HASH_PRIVATE_MMAP != 0
+    Hash_Private_File_Map map;
+    if (hash_private_file_map(path, strchr(mode, 'b') != NULL, &map))
+    {
+        for (size_t i = 0; i < map.size; i += HASH_PRIVATE_FILE_SLICE)
+            update(s, &map.data[i], map.size - i < HASH_PRIVATE_FILE_SLICE ? map.size - i : HASH_PRIVATE_FILE_SLICE);
+        hash_private_file_unmap(&map);
+        return 1;
+    }
+#endif
+
+    FILE* f = fopen(path, mode);
+    if (f == NULL) return 0;
+
+    char chunk[HASH_FILE_CHUNK_SIZE];
+    size_t size;
+    while ((size = fread(chunk, 1, sizeof(chunk), f)) != 0)
+        update(s, chunk, size);
+
+    const int ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
 #define HASH_DEFINE_UTIL_SWAP_ENDIAN(type) \
     HASH_INLINE type hash_util_swap_endian_##type(type u) \
     { \
@@ -169,6 +860,31 @@ HASH_INLINE uint32_t hash_util_left_rotate_u32(uint32_t n, unsigned int c)
 {
     return (n << c) | (n >> (32 - c));
 }
+
+// compares two digests or macs in constant time, returns 1 if they are equal
+HASH_INLINE int hash_util_digest_equal(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    volatile uint8_t diff = 0;
+    for (size_t i = 0; i < size; ++i)
+        diff = diff | (uint8_t)(a[i] ^ b[i]); // no compound assignment, C++20 deprecates it on volatile
+    return diff == 0;
+}
+
+// decodes 2 * size hex chars into size bytes, returns 0 if str contains anything else
+HASH_INLINE int hash_util_hex_string_to_char_array(const char* str, size_t size, unsigned char* out)
+{
+    for (size_t i = 0; i < 2 * size; ++i)
+    {
+        const char c = str[i];
+        unsigned char nibble;
+        if (c >= '0' && c <= '9')      nibble = (unsigned char)(c - '0');
+        else if (c >= 'a' && c <= 'f') nibble = (unsigned char)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') nibble = (unsigned char)(c - 'A' + 10);
+        else return 0;
+        out[i / 2] = (unsigned char)(i % 2 == 0 ? nibble << 4 : out[i / 2] | nibble);
+    }
+    return 1;
+}
 // ================================Util====================================
 
 
@@ -180,6 +896,10 @@ typedef struct
     uint8_t bufferSize;
     uint32_t h[8];
     uint8_t buffer[64];
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    int hardware; // 1 if ctx is used instead of the software rounds
+    mbedtls_sha256_context ctx;
+#endif
 } Hash_Private_Sha256;
 typedef Hash_Private_Sha256 Hash_Sha256[1];
 
@@ -234,16 +954,23 @@ HASH_INLINE void hash_private_sha256_compress(Hash_Sha256 s, const uint32_t* con
 }
 
 
-HASH_INLINE void hash_private_sha256_transform(Hash_Sha256 s)
+HASH_INLINE void hash_private_sha256_transform(Hash_Sha256 s, const uint8_t* block)
 {
-    static uint32_t w[64];
+#if HASH_PRIVATE_SHA256_ACCEL == 1
+    if (hash_private_sha256_accel_supported())
+    {
+        hash_private_sha256_accel_transform(s->h, block);
+        return;
+    }
+#endif
+    uint32_t w[64];
     for (size_t i = 0; i < 16; ++i)
     {
         uint8_t* c = (uint8_t*)&w[i];
-        c[0] = s->buffer[4 * i];
-        c[1] = s->buffer[4 * i + 1];
-        c[2] = s->buffer[4 * i + 2];
-        c[3] = s->buffer[4 * i + 3];
+        c[0] = block[4 * i];
+        c[1] = block[4 * i + 1];
+        c[2] = block[4 * i + 2];
+        c[3] = block[4 * i + 3];
         w[i] = hash_util_is_little_endian() ? hash_util_swap_endian_uint32_t(w[i]) : w[i];
     }
 
@@ -257,10 +984,32 @@ HASH_INLINE void hash_private_sha256_transform(Hash_Sha256 s)
 }
 
 
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+HASH_INLINE void hash_private_sha256_hw_start(Hash_Sha256 s, int is224)
+{
+    s->hardware = 1;
+    mbedtls_sha256_init(&s->ctx);
+    HASH_PRIVATE_MBEDTLS(mbedtls_sha256_starts)(&s->ctx, is224);
+}
+
+// the digest is stored in h so the hexdigest functions work for both backends
+HASH_INLINE void hash_private_sha256_hw_finish(Hash_Sha256 s)
+{
+    uint8_t digest[32] = { 0 };
+    HASH_PRIVATE_MBEDTLS(mbedtls_sha256_finish)(&s->ctx, digest);
+    mbedtls_sha256_free(&s->ctx);
+    s->hardware = 0;
+    for (size_t i = 0; i < 8; ++i)
+        s->h[i] = ((uint32_t)digest[4 * i] << 24) | ((uint32_t)digest[4 * i + 1] << 16) | ((uint32_t)digest[4 * i + 2] << 8) | (uint32_t)digest[4 * i + 3];
+}
+#endif // HASH_PRIVATE_SHA2_ESP32
 
 
 HASH_INLINE void hash_sha256_init(Hash_Sha256 s)
 {
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    hash_private_sha256_hw_start(s, 0);
+#endif
     s->bitlen = 0;
     s->bufferSize = 0;
     s->h[0] = 0x6a09e667;
@@ -277,16 +1026,42 @@ HASH_INLINE void hash_sha256_init(Hash_Sha256 s)
 HASH_INLINE void hash_sha256_update_binary(Hash_Sha256 s, const char* data, size_t size)
 {
     const uint8_t* d = (const uint8_t*)data;
-    for (size_t i = 0; i < size; ++i)
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    if (s->hardware)
     {
-        s->buffer[s->bufferSize++] = d[i];
-        if (s->bufferSize == 64)
-        {
-            hash_private_sha256_transform(s);
-            s->bufferSize = 0;
-            s->bitlen += 512;
-        }
+        HASH_PRIVATE_MBEDTLS(mbedtls_sha256_update)(&s->ctx, d, size);
+        return;
+    }
+#endif
+
+    // fill up a partially filled block first
+    if (s->bufferSize != 0)
+    {
+        const size_t fill = size < (size_t)(64 - s->bufferSize) ? size : (size_t)(64 - s->bufferSize);
+        memcpy(&s->buffer[s->bufferSize], d, fill);
+        s->bufferSize += (uint8_t)fill;
+        d += fill;
+        size -= fill;
+
+        if (s->bufferSize < 64)
+            return;
+
+        hash_private_sha256_transform(s, s->buffer);
+        s->bufferSize = 0;
+        s->bitlen += 512;
     }
+
+    // compress whole blocks directly from the input, no copy into the buffer
+    const size_t blocks = size / 64;
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        hash_private_sha256_transform(s, &d[i * 64]);
+        s->bitlen += 512;
+    }
+
+    // buffer the remaining tail
+    memcpy(s->buffer, &d[blocks * 64], size % 64);
+    s->bufferSize = (uint8_t)(size % 64);
 }
 
 HASH_INLINE void hash_sha256_update(Hash_Sha256 s, const char* data)
@@ -296,6 +1071,13 @@ HASH_INLINE void hash_sha256_update(Hash_Sha256 s, const char* data)
 
 HASH_INLINE void hash_sha256_finalize(Hash_Sha256 s)
 {
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    if (s->hardware)
+    {
+        hash_private_sha256_hw_finish(s);
+        return;
+    }
+#endif
     uint8_t start = s->bufferSize;
     uint8_t end = s->bufferSize < 56 ? 56 : 64;
 
@@ -304,27 +1086,32 @@ HASH_INLINE void hash_sha256_finalize(Hash_Sha256 s)
 
     if (s->bufferSize >= 56)
     {
-        hash_private_sha256_transform(s);
+        hash_private_sha256_transform(s, s->buffer);
         memset(s->buffer, 0, 56);
     }
 
     s->bitlen += s->bufferSize * 8;
     uint64_t* const size = (uint64_t*)&s->buffer[64 - 8];
     *size = hash_util_is_little_endian() ? hash_util_swap_endian_uint64_t(s->bitlen) : s->bitlen;
-    hash_private_sha256_transform(s);
+    hash_private_sha256_transform(s, s->buffer);
 }
 
 
+// the raw digest in big endian byte order
+HASH_INLINE void hash_sha256_digest(const Hash_Sha256 s, uint8_t out[32])
+{
+    for (size_t i = 0; i < 32; ++i)
+        out[i] = (uint8_t)(s->h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least 65 (Null term char)
 HASH_INLINE const char* hash_sha256_hexdigest(const Hash_Sha256 s, char* buffer)
 {
-    static char hex[65];
+    HASH_INTERNAL_BUFFER char hex[65];
     char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 8; ++i)
-    {
-        sprintf(&buff[i * 8], "%08" PRIx32, s->h[i]);
-    }
-    buff[64] = 0;
+    uint8_t digest[32];
+    hash_sha256_digest(s, digest);
+    hash_util_char_array_to_hex_string(digest, 32, buff);
     return buff;
 }
 
@@ -343,9 +1130,18 @@ HASH_INLINE const char* hash_sha256(const char* str, char* buffer)
     return hash_sha256_binary(str, strlen(str), buffer);
 }
 
+HASH_INLINE void hash_private_sha256_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha256_update_binary((Hash_Private_Sha256*)s, data, size);
+}
+
 HASH_INLINE const char* hash_sha256_file(const char* path, const char* mode, char* buffer)
 {
-    return hash_util_hash_file(path, mode, hash_sha256_binary, buffer);
+    Hash_Sha256 s;
+    hash_sha256_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_sha256_file_update, s);
+    hash_sha256_finalize(s);
+    return read ? hash_sha256_hexdigest(s, buffer) : "";
 }
 
 HASH_INLINE const char* hash_sha256_easy(const char* str)
@@ -355,7 +1151,7 @@ HASH_INLINE const char* hash_sha256_easy(const char* str)
 
 HASH_INLINE const char* hash_sha256_file_easy(const char* path, const char* mode)
 {
-    return hash_util_hash_file(path, mode, hash_sha256_binary, NULL);
+    return hash_sha256_file(path, mode, NULL);
 }
 // ===============================Hash_Sha256===================================
 
@@ -365,6 +1161,9 @@ typedef Hash_Sha256 Hash_Sha224;
 
 HASH_INLINE void hash_sha224_init(Hash_Sha224 s)
 {
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    hash_private_sha256_hw_start(s, 1);
+#endif
     s->bitlen = 0;
     s->bufferSize = 0;
     s->h[0] = 0xC1059ED8;
@@ -394,16 +1193,21 @@ HASH_INLINE void hash_sha224_finalize(Hash_Sha224 s)
 }
 
 
+// the raw digest in big endian byte order
+HASH_INLINE void hash_sha224_digest(const Hash_Sha224 s, uint8_t out[28])
+{
+    for (size_t i = 0; i < 28; ++i)
+        out[i] = (uint8_t)(s->h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least 57 (Null term char)
 HASH_INLINE const char* hash_sha224_hexdigest(const Hash_Sha224 s, char* buffer)
 {
-    static char hex[57];
+    HASH_INTERNAL_BUFFER char hex[57];
     char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 7; ++i)
-    {
-        sprintf(&buff[i * 8], "%08" PRIx32, s->h[i]);
-    }
-    buff[56] = 0;
+    uint8_t digest[28];
+    hash_sha224_digest(s, digest);
+    hash_util_char_array_to_hex_string(digest, 28, buff);
     return buff;
 }
 
@@ -422,9 +1226,18 @@ HASH_INLINE const char* hash_sha224(const char* str, char* buffer)
     return hash_sha224_binary(str, strlen(str), buffer);
 }
 
+HASH_INLINE void hash_private_sha224_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha224_update_binary((Hash_Private_Sha256*)s, data, size);
+}
+
 HASH_INLINE const char* hash_sha224_file(const char* path, const char* mode, char* buffer)
 {
-    return hash_util_hash_file(path, mode, hash_sha224_binary, buffer);
+    Hash_Sha224 s;
+    hash_sha224_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_sha224_file_update, s);
+    hash_sha224_finalize(s);
+    return read ? hash_sha224_hexdigest(s, buffer) : "";
 }
 
 HASH_INLINE const char* hash_sha224_easy(const char* str)
@@ -434,7 +1247,7 @@ HASH_INLINE const char* hash_sha224_easy(const char* str)
 
 HASH_INLINE const char* hash_sha224_file_easy(const char* path, const char* mode)
 {
-    return hash_util_hash_file(path, mode, hash_sha224_binary, NULL);
+    return hash_sha224_file(path, mode, NULL);
 }
 // ===============================Hash_Sha224===================================
 
@@ -447,6 +1260,10 @@ typedef struct
     uint64_t h[8];
     uint8_t buffer[128];
     size_t t; // only use for sha512t
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    int hardware; // 1 if ctx is used instead of the software rounds
+    mbedtls_sha512_context ctx;
+#endif
 } Hash_Private_Sha512;
 typedef Hash_Private_Sha512 Hash_Sha512[1];
 
@@ -509,20 +1326,20 @@ HASH_INLINE void hash_private_sha512_compress(Hash_Sha512 s, const uint64_t* con
 }
 
 
-HASH_INLINE void hash_private_sha512_transform(Hash_Sha512 s)
+HASH_INLINE void hash_private_sha512_transform(Hash_Sha512 s, const uint8_t* block)
 {
-    static uint64_t w[80];
+    uint64_t w[80];
     for (size_t i = 0; i < 16; ++i)
     {
         uint8_t* c = (uint8_t*)&w[i];
-        c[0] = s->buffer[8 * i];
-        c[1] = s->buffer[8 * i + 1];
-        c[2] = s->buffer[8 * i + 2];
-        c[3] = s->buffer[8 * i + 3];
-        c[4] = s->buffer[8 * i + 4];
-        c[5] = s->buffer[8 * i + 5];
-        c[6] = s->buffer[8 * i + 6];
-        c[7] = s->buffer[8 * i + 7];
+        c[0] = block[8 * i];
+        c[1] = block[8 * i + 1];
+        c[2] = block[8 * i + 2];
+        c[3] = block[8 * i + 3];
+        c[4] = block[8 * i + 4];
+        c[5] = block[8 * i + 5];
+        c[6] = block[8 * i + 6];
+        c[7] = block[8 * i + 7];
         w[i] = hash_util_is_little_endian() ? hash_util_swap_endian_uint64_t(w[i]) : w[i];
     }
 
@@ -536,10 +1353,37 @@ HASH_INLINE void hash_private_sha512_transform(Hash_Sha512 s)
 }
 
 
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+HASH_INLINE void hash_private_sha512_hw_start(Hash_Sha512 s, int is384)
+{
+    s->hardware = 1;
+    mbedtls_sha512_init(&s->ctx);
+    HASH_PRIVATE_MBEDTLS(mbedtls_sha512_starts)(&s->ctx, is384);
+}
+
+// the digest is stored in h so the hexdigest functions work for both backends
+HASH_INLINE void hash_private_sha512_hw_finish(Hash_Sha512 s)
+{
+    uint8_t digest[64] = { 0 };
+    HASH_PRIVATE_MBEDTLS(mbedtls_sha512_finish)(&s->ctx, digest);
+    mbedtls_sha512_free(&s->ctx);
+    s->hardware = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        uint64_t h = 0;
+        for (size_t k = 0; k < 8; ++k)
+            h = (h << 8) | digest[8 * i + k];
+        s->h[i] = h;
+    }
+}
+#endif // HASH_PRIVATE_SHA2_ESP32
 
 
 HASH_INLINE void hash_sha512_init(Hash_Sha512 s)
 {
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    hash_private_sha512_hw_start(s, 0);
+#endif
     s->bitlen = 0;
     s->bufferSize = 0;
     s->h[0] = 0x6a09e667f3bcc908;
@@ -561,16 +1405,42 @@ HASH_INLINE void hash_sha512_reset(Hash_Sha512 s)
 HASH_INLINE void hash_sha512_update_binary(Hash_Sha512 s, const char* data, size_t size)
 {
     const uint8_t* d = (const uint8_t*)data;
-    for (size_t i = 0; i < size; ++i)
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    if (s->hardware)
     {
-        s->buffer[s->bufferSize++] = d[i];
-        if (s->bufferSize == 128)
-        {
-            hash_private_sha512_transform(s);
-            s->bufferSize = 0;
-            s->bitlen += 1024;
-        }
+        HASH_PRIVATE_MBEDTLS(mbedtls_sha512_update)(&s->ctx, d, size);
+        return;
+    }
+#endif
+
+    // fill up a partially filled block first
+    if (s->bufferSize != 0)
+    {
+        const size_t fill = size < (size_t)(128 - s->bufferSize) ? size : (size_t)(128 - s->bufferSize);
+        memcpy(&s->buffer[s->bufferSize], d, fill);
+        s->bufferSize += (uint8_t)fill;
+        d += fill;
+        size -= fill;
+
+        if (s->bufferSize < 128)
+            return;
+
+        hash_private_sha512_transform(s, s->buffer);
+        s->bufferSize = 0;
+        s->bitlen += 1024;
+    }
+
+    // compress whole blocks directly from the input, no copy into the buffer
+    const size_t blocks = size / 128;
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        hash_private_sha512_transform(s, &d[i * 128]);
+        s->bitlen += 1024;
     }
+
+    // buffer the remaining tail
+    memcpy(s->buffer, &d[blocks * 128], size % 128);
+    s->bufferSize = (uint8_t)(size % 128);
 }
 
 HASH_INLINE void hash_sha512_update(Hash_Sha512 s, const char* data)
@@ -580,6 +1450,13 @@ HASH_INLINE void hash_sha512_update(Hash_Sha512 s, const char* data)
 
 HASH_INLINE void hash_sha512_finalize(Hash_Sha512 s)
 {
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    if (s->hardware)
+    {
+        hash_private_sha512_hw_finish(s);
+        return;
+    }
+#endif
     uint8_t start = s->bufferSize;
     uint8_t end = s->bufferSize < 112 ? 120 : 128; // 120 instead of 112 because m_Bitlen is a 64 bit uint
 
@@ -588,27 +1465,32 @@ HASH_INLINE void hash_sha512_finalize(Hash_Sha512 s)
 
     if (s->bufferSize >= 112)
     {
-        hash_private_sha512_transform(s);
+        hash_private_sha512_transform(s, s->buffer);
         memset(s->buffer, 0, 120);
     }
 
     s->bitlen += s->bufferSize * 8;
     uint64_t* const size = (uint64_t*)&s->buffer[128 - 8]; // -8 instead of -16 because we use an uint64 instead of uint128
     *size = hash_util_is_little_endian() ? hash_util_swap_endian_uint64_t(s->bitlen) : s->bitlen;
-    hash_private_sha512_transform(s);
+    hash_private_sha512_transform(s, s->buffer);
 }
 
 
+// the raw digest in big endian byte order
+HASH_INLINE void hash_sha512_digest(const Hash_Sha512 s, uint8_t out[64])
+{
+    for (size_t i = 0; i < 64; ++i)
+        out[i] = (uint8_t)(s->h[i / 8] >> (56 - 8 * (i % 8)));
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least 129 (Null term char)
 HASH_INLINE const char* hash_sha512_hexdigest(const Hash_Sha512 s, char* buffer)
 {
-    static char hex[129];
+    HASH_INTERNAL_BUFFER char hex[129];
     char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 8; ++i)
-    {
-        sprintf(&buff[i * 16], "%016" PRIx64, s->h[i]);
-    }
-    buff[128] = 0;
+    uint8_t digest[64];
+    hash_sha512_digest(s, digest);
+    hash_util_char_array_to_hex_string(digest, 64, buff);
     return buff;
 }
 
@@ -627,9 +1509,18 @@ HASH_INLINE const char* hash_sha512(const char* str, char* buffer)
     return hash_sha512_binary(str, strlen(str), buffer);
 }
 
+HASH_INLINE void hash_private_sha512_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha512_update_binary((Hash_Private_Sha512*)s, data, size);
+}
+
 HASH_INLINE const char* hash_sha512_file(const char* path, const char* mode, char* buffer)
 {
-    return hash_util_hash_file(path, mode, hash_sha512_binary, buffer);
+    Hash_Sha512 s;
+    hash_sha512_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_sha512_file_update, s);
+    hash_sha512_finalize(s);
+    return read ? hash_sha512_hexdigest(s, buffer) : "";
 }
 
 HASH_INLINE const char* hash_sha512_easy(const char* str)
@@ -639,19 +1530,23 @@ HASH_INLINE const char* hash_sha512_easy(const char* str)
 
 HASH_INLINE const char* hash_sha512_file_easy(const char* path, const char* mode)
 {
-    return hash_util_hash_file(path, mode, hash_sha512_binary, NULL);
+    return hash_sha512_file(path, mode, NULL);
+}
+
+// hashes count independent messages at once (fast for many short messages), digests must hold count * 64 bytes
+// the raw digests are written in big endian order: message i at digests[64 * i]
+HASH_INLINE void hash_sha512_batch(const char* const* data, const size_t* sizes, size_t count, uint8_t* digests)
+{
+    hash_private_sha512_mb(data, sizes, count, digests);
 }
 // ===============================Hash_Sha512===================================
 
 
 // ===============================Hash_Sha512T==================================
 typedef Hash_Sha512 Hash_Sha512T;
-HASH_INLINE void hash_sha512t_init(Hash_Sha512T s, size_t t)
+HASH_INLINE void hash_private_sha512t_iv(Hash_Sha512T s, size_t t)
 {
-    assert(t != 384 && "t = 384 is not allowed use Hash_Sha384 instead!");
-    assert(t >= 4 && t <= 2048 && "t must satisfy t >= 4 && t <= 2048!");
-    s->bitlen = 0;
-    s->bufferSize = 0;
+    // initial values are the sha512 of "SHA-512/t" with modified initial values (FIPS 180-4 5.3.6)
     s->h[0] = 0xcfac43c256196cad;
     s->h[1] = 0x1ec20b20216f029e;
     s->h[2] = 0x99cb56d75b315d8e;
@@ -660,26 +1555,51 @@ HASH_INLINE void hash_sha512t_init(Hash_Sha512T s, size_t t)
     s->h[5] = 0x3ea0cd298e9bc9ba;
     s->h[6] = 0xba267c0e5ee418ce;
     s->h[7] = 0xfe4568bcb6db84dc;
-    s->t = t;
 
-    char str[13], buff[129];
-    memset(str, 0, 13);
-    sprintf(str, "SHA-512/%u", (unsigned int)t);
+    char str[13] = "SHA-512/";
+    size_t size = 8;
+    char digits[4];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + t % 10);
+        t /= 10;
+    } while (t != 0);
+    while (count != 0)
+        str[size++] = digits[--count];
 
-    hash_sha512_update(s, str);
-    hash_sha512_finalize(s);
-    hash_sha512_hexdigest(s, buff);
+    hash_sha512_update_binary(s, str, size);
+    hash_sha512_finalize(s); // the digest words are the initial values
     hash_sha512_reset(s);
+}
 
-    size_t k = 0;
-    for (size_t i = 0; i < 128; i += 16)
+HASH_INLINE void hash_sha512t_init(Hash_Sha512T s, size_t t)
+{
+    assert(t != 384 && "t = 384 is not allowed use Hash_Sha384 instead!");
+    assert(t >= 4 && t <= 2048 && "t must satisfy t >= 4 && t <= 2048!");
+    static const uint64_t iv224[8] =
     {
-        char hex[17];
-        hex[16] = 0;
-        memcpy(hex, &buff[i], 16);
-        s->h[k++] = strtoull(hex, NULL, 16);
-    }
-};
+        0x8c3d37c819544da2, 0x73e1996689dcd4d6, 0x1dfab7ae32ff9c82, 0x679dd514582f9fcf,
+        0x0f6d2b697bd44da8, 0x77e36f7304c48942, 0x3f9d85a86a1d36c8, 0x1112e6ad91d692a1
+    };
+    static const uint64_t iv256[8] =
+    {
+        0x22312194fc2bf72c, 0x9f555fa3c84c64c2, 0x2393b86b6f53b151, 0x963877195940eabd,
+        0x96283ee2a88effe3, 0xbe5e1e2553863992, 0x2b0199fc2c85b8aa, 0x0eb72ddc81c52ca2
+    };
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    s->hardware = 0; // mbedtls has no custom initial hash values, always use software
+#endif
+    s->bitlen = 0;
+    s->bufferSize = 0;
+    s->t = t;
+    if (t == 224)
+        memcpy(s->h, iv224, sizeof(iv224));
+    else if (t == 256)
+        memcpy(s->h, iv256, sizeof(iv256));
+    else
+        hash_private_sha512t_iv(s, t);
+}
 
 
 HASH_INLINE void hash_sha512t_update_binary(Hash_Sha512T s, const char* data, size_t size)
@@ -698,16 +1618,31 @@ HASH_INLINE void hash_sha512t_finalize(Hash_Sha512T s)
 }
 
 
+// the leftmost t bits of the raw digest in big endian byte order, out must hold (t+7)/8 bytes (at most 64)
+HASH_INLINE void hash_sha512t_digest(const Hash_Sha512T s, uint8_t* out)
+{
+    const size_t t = s->t < 512 ? s->t : 512;
+    for (size_t i = 0; i < (t + 7) / 8; ++i)
+        out[i] = (uint8_t)(s->h[i / 8] >> (56 - 8 * (i % 8)));
+    if (t % 8 != 0)
+        out[t / 8] &= (uint8_t)(0xff << (8 - t % 8));
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least (t/4)+1 (Null term char)
 HASH_INLINE const char* hash_sha512t_hexdigest(const Hash_Sha512T s, char* buffer)
 {
-    static char hex[513]; // use max allowed size to avoid memory allocation
+    HASH_INTERNAL_BUFFER char hex[513]; // use max allowed size to avoid memory allocation
     char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 8; ++i)
+    const size_t t = s->t < 512 ? s->t : 512;
+    uint8_t digest[64];
+    hash_sha512t_digest(s, digest);
+    const size_t chars = t / 4;
+    hash_util_char_array_to_hex_string(digest, chars / 2, buff);
+    if (chars % 2 != 0) // the last char is half a byte
     {
-        sprintf(&buff[i * 16], "%016" PRIx64, s->h[i]);
+        buff[chars - 1] = "0123456789abcdef"[digest[chars / 2] >> 4];
+        buff[chars] = 0;
     }
-    buff[s->t / 4] = 0;
     return buff;
 }
 
@@ -731,100 +1666,257 @@ HASH_INLINE const char* hash_sha512t_easy(size_t t, const char* str)
     return hash_sha512t_binary(t, str, strlen(str), NULL);
 }
 
+HASH_INLINE void hash_private_sha512t_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha512t_update_binary((Hash_Private_Sha512*)s, data, size);
+}
+
 HASH_INLINE const char* hash_sha512t_file(size_t t, const char* path, const char* mode, char* buffer)
 {
-    long fsize;
-    char* content = hash_util_load_file(path, mode, &fsize);
-    if (content == NULL) return "";
-    const char* hash = hash_sha512t_binary(t, content, fsize, buffer);
-    if (content != NULL) free(content);
-    return hash;
+    Hash_Sha512T s;
+    hash_sha512t_init(s, t);
+    const int read = hash_util_read_file(path, mode, hash_private_sha512t_file_update, s);
+    hash_sha512t_finalize(s);
+    return read ? hash_sha512t_hexdigest(s, buffer) : "";
 }
 
 
 HASH_INLINE const char* hash_sha512t_file_easy(size_t t, const char* path, const char* mode)
 {
-    return hash_sha512t_file(t, path, mode, NULL);
+    return hash_sha512t_file(t, path, mode, NULL);
+}
+// ===============================Hash_Sha512T==================================
+
+
+// ===============================Hash_Sha384===================================
+typedef Hash_Sha512 Hash_Sha384;
+HASH_INLINE void hash_sha384_init(Hash_Sha384 s)
+{
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    hash_private_sha512_hw_start(s, 1);
+#endif
+    s->bitlen = 0;
+    s->bufferSize = 0;
+    s->h[0] = 0xcbbb9d5dc1059ed8;
+    s->h[1] = 0x629a292a367cd507;
+    s->h[2] = 0x9159015a3070dd17;
+    s->h[3] = 0x152fecd8f70e5939;
+    s->h[4] = 0x67332667ffc00b31;
+    s->h[5] = 0x8eb44a8768581511;
+    s->h[6] = 0xdb0c2e0d64f98fa7;
+    s->h[7] = 0x47b5481dbefa4fa4;
+};
+
+
+HASH_INLINE void hash_sha384_update_binary(Hash_Sha384 s, const char* data, size_t size)
+{
+    hash_sha512_update_binary(s, data, size);
+}
+
+HASH_INLINE void hash_sha384_update(Hash_Sha384 s, const char* data)
+{
+    hash_sha384_update_binary(s, data, strlen(data));
+}
+
+HASH_INLINE void hash_sha384_finalize(Hash_Sha384 s)
+{
+    hash_sha512_finalize(s);
+}
+
+
+// the raw digest in big endian byte order
+HASH_INLINE void hash_sha384_digest(const Hash_Sha384 s, uint8_t out[48])
+{
+    for (size_t i = 0; i < 48; ++i)
+        out[i] = (uint8_t)(s->h[i / 8] >> (56 - 8 * (i % 8)));
+}
+
+// if buffer == NULL returns internal buffer, buffer size must be at least 97 (Null term char)
+HASH_INLINE const char* hash_sha384_hexdigest(const Hash_Sha384 s, char* buffer)
+{
+    HASH_INTERNAL_BUFFER char hex[97]; // use max allowed size to avoid memory allocation
+    char* buff = buffer == NULL ? hex : buffer;
+    uint8_t digest[48];
+    hash_sha384_digest(s, digest);
+    hash_util_char_array_to_hex_string(digest, 48, buff);
+    return buff;
+}
+
+// if buffer == NULL returns internal buffer, buffer size must be at least 97 (Null term char)
+HASH_INLINE const char* hash_sha384_binary(const char* str, size_t size, char* buffer)
+{
+    Hash_Sha384 s;
+    hash_sha384_init(s);
+    hash_sha384_update_binary(s, str, size);
+    hash_sha384_finalize(s);
+    return hash_sha384_hexdigest(s, buffer);
+}
+
+HASH_INLINE const char* hash_sha384(const char* str, char* buffer)
+{
+    return hash_sha384_binary(str, strlen(str), buffer);
+}
+
+HASH_INLINE void hash_private_sha384_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha384_update_binary((Hash_Private_Sha512*)s, data, size);
+}
+
+HASH_INLINE const char* hash_sha384_file(const char* path, const char* mode, char* buffer)
+{
+    Hash_Sha384 s;
+    hash_sha384_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_sha384_file_update, s);
+    hash_sha384_finalize(s);
+    return read ? hash_sha384_hexdigest(s, buffer) : "";
+}
+
+HASH_INLINE const char* hash_sha384_easy(const char* str)
+{
+    return hash_sha384_binary(str, strlen(str), NULL);
+}
+
+HASH_INLINE const char* hash_sha384_file_easy(const char* path, const char* mode)
+{
+    return hash_sha384_file(path, mode, NULL);
+}
+// ===============================Hash_Sha384===================================
+
+
+// ================================Hash_Hmac====================================
+typedef struct
+{
+    Hash_Private_Sha256 inner;
+    Hash_Private_Sha256 outer;
+} Hash_Private_Hmac_Sha256;
+typedef Hash_Private_Hmac_Sha256 Hash_Hmac_Sha256[1];
+
+// the pad states are copied per message, that only works with the software rounds
+HASH_INLINE void hash_private_hmac_sha256_start(Hash_Sha256 s)
+{
+    hash_sha256_init(s);
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    mbedtls_sha256_free(&s->ctx);
+    s->hardware = 0;
+#endif
 }
-// ===============================Hash_Sha512T==================================
 
-
-// ===============================Hash_Sha384===================================
-typedef Hash_Sha512 Hash_Sha384;
-HASH_INLINE void hash_sha384_init(Hash_Sha384 s)
+// hashes the key into the inner and outer pad states
+HASH_INLINE void hash_hmac_sha256_init(Hash_Hmac_Sha256 h, const char* key, size_t size)
 {
-    s->bitlen = 0;
-    s->bufferSize = 0;
-    s->h[0] = 0xcbbb9d5dc1059ed8;
-    s->h[1] = 0x629a292a367cd507;
-    s->h[2] = 0x9159015a3070dd17;
-    s->h[3] = 0x152fecd8f70e5939;
-    s->h[4] = 0x67332667ffc00b31;
-    s->h[5] = 0x8eb44a8768581511;
-    s->h[6] = 0xdb0c2e0d64f98fa7;
-    s->h[7] = 0x47b5481dbefa4fa4;
-};
+    uint8_t pad[64] = { 0 };
+    if (size > 64)
+    {
+        Hash_Sha256 s;
+        hash_sha256_init(s);
+        hash_sha256_update_binary(s, key, size);
+        hash_sha256_finalize(s);
+        hash_sha256_digest(s, pad);
+    }
+    else if (size != 0)
+        memcpy(pad, key, size);
 
+    for (size_t i = 0; i < 64; ++i)
+        pad[i] ^= 0x36;
+    hash_private_hmac_sha256_start(&h->inner);
+    hash_sha256_update_binary(&h->inner, (const char*)pad, 64);
 
-HASH_INLINE void hash_sha384_update_binary(Hash_Sha384 s, const char* data, size_t size)
+    for (size_t i = 0; i < 64; ++i)
+        pad[i] ^= 0x36 ^ 0x5c;
+    hash_private_hmac_sha256_start(&h->outer);
+    hash_sha256_update_binary(&h->outer, (const char*)pad, 64);
+}
+
+HASH_INLINE void hash_hmac_sha256_update_binary(Hash_Hmac_Sha256 h, const char* data, size_t size)
 {
-    hash_sha512_update_binary(s, data, size);
+    hash_sha256_update_binary(&h->inner, data, size);
 }
 
-HASH_INLINE void hash_sha384_update(Hash_Sha384 s, const char* data)
+HASH_INLINE void hash_hmac_sha256_finalize(Hash_Hmac_Sha256 h, uint8_t out[32])
 {
-    hash_sha384_update_binary(s, data, strlen(data));
+    hash_sha256_finalize(&h->inner);
+    hash_sha256_digest(&h->inner, out);
+    hash_sha256_update_binary(&h->outer, (const char*)out, 32);
+    hash_sha256_finalize(&h->outer);
+    hash_sha256_digest(&h->outer, out);
 }
 
-HASH_INLINE void hash_sha384_finalize(Hash_Sha384 s)
+// mac of one message, key is left untouched so the pads are only computed once
+HASH_INLINE void hash_hmac_sha256_binary(const Hash_Hmac_Sha256 key, const char* data, size_t size, uint8_t out[32])
 {
-    hash_sha512_finalize(s);
+    Hash_Hmac_Sha256 h;
+    memcpy(h, key, sizeof(Hash_Hmac_Sha256));
+    hash_hmac_sha256_update_binary(h, data, size);
+    hash_hmac_sha256_finalize(h, out);
 }
 
 
-// if buffer == NULL returns internal buffer, buffer size must be at least 97 (Null term char)
-HASH_INLINE const char* hash_sha384_hexdigest(const Hash_Sha384 s, char* buffer)
+typedef struct
 {
-    static char hex[97]; // use max allowed size to avoid memory allocation
-    char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 6; ++i)
-    {
-        sprintf(&buff[i * 16], "%016" PRIx64, s->h[i]);
-    }
-    buff[96] = 0;
-    return buff;
-}
+    Hash_Private_Sha512 inner;
+    Hash_Private_Sha512 outer;
+} Hash_Private_Hmac_Sha512;
+typedef Hash_Private_Hmac_Sha512 Hash_Hmac_Sha512[1];
 
-// if buffer == NULL returns internal buffer, buffer size must be at least 97 (Null term char)
-HASH_INLINE const char* hash_sha384_binary(const char* str, size_t size, char* buffer)
+// the pad states are copied per message, that only works with the software rounds
+HASH_INLINE void hash_private_hmac_sha512_start(Hash_Sha512 s)
 {
-    Hash_Sha384 s;
-    hash_sha384_init(s);
-    hash_sha384_update_binary(s, str, size);
-    hash_sha384_finalize(s);
-    return hash_sha384_hexdigest(s, buffer);
+    hash_sha512_init(s);
+#if HASH_PRIVATE_SHA2_ESP32 == 1
+    mbedtls_sha512_free(&s->ctx);
+    s->hardware = 0;
+#endif
 }
 
-HASH_INLINE const char* hash_sha384(const char* str, char* buffer)
+// hashes the key into the inner and outer pad states
+HASH_INLINE void hash_hmac_sha512_init(Hash_Hmac_Sha512 h, const char* key, size_t size)
 {
-    return hash_sha384_binary(str, strlen(str), buffer);
+    uint8_t pad[128] = { 0 };
+    if (size > 128)
+    {
+        Hash_Sha512 s;
+        hash_sha512_init(s);
+        hash_sha512_update_binary(s, key, size);
+        hash_sha512_finalize(s);
+        hash_sha512_digest(s, pad);
+    }
+    else if (size != 0)
+        memcpy(pad, key, size);
+
+    for (size_t i = 0; i < 128; ++i)
+        pad[i] ^= 0x36;
+    hash_private_hmac_sha512_start(&h->inner);
+    hash_sha512_update_binary(&h->inner, (const char*)pad, 128);
+
+    for (size_t i = 0; i < 128; ++i)
+        pad[i] ^= 0x36 ^ 0x5c;
+    hash_private_hmac_sha512_start(&h->outer);
+    hash_sha512_update_binary(&h->outer, (const char*)pad, 128);
 }
 
-HASH_INLINE const char* hash_sha384_file(const char* path, const char* mode, char* buffer)
+HASH_INLINE void hash_hmac_sha512_update_binary(Hash_Hmac_Sha512 h, const char* data, size_t size)
 {
-    return hash_util_hash_file(path, mode, hash_sha384_binary, buffer);
+    hash_sha512_update_binary(&h->inner, data, size);
 }
 
-HASH_INLINE const char* hash_sha384_easy(const char* str)
+HASH_INLINE void hash_hmac_sha512_finalize(Hash_Hmac_Sha512 h, uint8_t out[64])
 {
-    return hash_sha384_binary(str, strlen(str), NULL);
+    hash_sha512_finalize(&h->inner);
+    hash_sha512_digest(&h->inner, out);
+    hash_sha512_update_binary(&h->outer, (const char*)out, 64);
+    hash_sha512_finalize(&h->outer);
+    hash_sha512_digest(&h->outer, out);
 }
 
-HASH_INLINE const char* hash_sha384_file_easy(const char* path, const char* mode)
+// mac of one message, key is left untouched so the pads are only computed once
+HASH_INLINE void hash_hmac_sha512_binary(const Hash_Hmac_Sha512 key, const char* data, size_t size, uint8_t out[64])
 {
-    return hash_util_hash_file(path, mode, hash_sha384_binary, NULL);
+    Hash_Hmac_Sha512 h;
+    memcpy(h, key, sizeof(Hash_Hmac_Sha512));
+    hash_hmac_sha512_update_binary(h, data, size);
+    hash_hmac_sha512_finalize(h, out);
 }
-// ===============================Hash_Sha384===================================
+// ================================Hash_Hmac====================================
 #endif // HASH_ENABLE_SHA2
 
 
@@ -961,16 +2053,21 @@ HASH_INLINE void hash_sha1_finalize(Hash_Sha1 s)
 }
 
 
+// the raw digest in big endian byte order
+HASH_INLINE void hash_sha1_digest(const Hash_Sha1 s, uint8_t out[20])
+{
+    for (size_t i = 0; i < 20; ++i)
+        out[i] = (uint8_t)(s->h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least 41 (Null term char)
 HASH_INLINE const char* hash_sha1_hexdigest(const Hash_Sha1 s, char* buffer)
 {
-    static char hex[41]; // use max allowed size to avoid memory allocation
+    HASH_INTERNAL_BUFFER char hex[41]; // use max allowed size to avoid memory allocation
     char* buff = buffer == NULL ? hex : buffer;
-    for (size_t i = 0; i < 5; ++i)
-    {
-        sprintf(&buff[i * 8], "%08" PRIx32, s->h[i]);
-    }
-    buff[40] = 0;
+    uint8_t digest[20];
+    hash_sha1_digest(s, digest);
+    hash_util_char_array_to_hex_string(digest, 20, buff);
     return buff;
 }
 
@@ -989,9 +2086,18 @@ HASH_INLINE const char* hash_sha1(const char* str, char* buffer)
     return hash_sha1_binary(str, strlen(str), buffer);
 }
 
+HASH_INLINE void hash_private_sha1_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha1_update_binary((Hash_Private_Sha1*)s, data, size);
+}
+
 HASH_INLINE const char* hash_sha1_file(const char* path, const char* mode, char* buffer)
 {
-    return hash_util_hash_file(path, mode, hash_sha1_binary, buffer);
+    Hash_Sha1 s;
+    hash_sha1_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_sha1_file_update, s);
+    hash_sha1_finalize(s);
+    return read ? hash_sha1_hexdigest(s, buffer) : "";
 }
 
 HASH_INLINE const char* hash_sha1_easy(const char* str)
@@ -1001,7 +2107,7 @@ HASH_INLINE const char* hash_sha1_easy(const char* str)
 
 HASH_INLINE const char* hash_sha1_file_easy(const char* path, const char* mode)
 {
-    return hash_util_hash_file(path, mode, hash_sha1_binary, NULL);
+    return hash_sha1_file(path, mode, NULL);
 }
 // ================================Hash_Sha1====================================
 #endif // HASH_ENABLE_SHA1
@@ -1293,17 +2399,21 @@ HASH_INLINE void  hash_md5_finalize(Hash_MD5 m)
 }
 
 
+// the raw digest, only valid after hash_md5_finalize
+HASH_INLINE void hash_md5_digest(const Hash_MD5 m, uint8_t out[16])
+{
+    memcpy(out, m->digest, 16);
+}
+
 // if buffer == NULL returns internal buffer, buffer size must be at least 33 (Null term char)
 HASH_INLINE const char* hash_md5_hexdigest(const Hash_MD5 m, char* buffer)
 {
     if (!m->finalized)
         return "";
 
-    static char hex[33];
+    HASH_INTERNAL_BUFFER char hex[33];
     char* buf = buffer == NULL ? hex : buffer;
-    for (int i = 0; i < 16; i++)
-        sprintf(buf + i * 2, "%02x", m->digest[i]);
-    buf[32] = 0;
+    hash_util_char_array_to_hex_string(m->digest, 16, buf);
     return buf;
 }
 
@@ -1323,9 +2433,18 @@ HASH_INLINE const char* hash_md5(const char* str, char* buffer)
     return hash_md5_binary(str, strlen(str), buffer);
 }
 
+HASH_INLINE void hash_private_md5_file_update(void* s, const char* data, size_t size)
+{
+    hash_md5_update_binary((Hash_Private_MD5*)s, data, size);
+}
+
 HASH_INLINE const char* hash_md5_file(const char* path, const char* mode, char* buffer)
 {
-    return hash_util_hash_file(path, mode, hash_md5_binary, buffer);
+    Hash_MD5 s;
+    hash_md5_init(s);
+    const int read = hash_util_read_file(path, mode, hash_private_md5_file_update, s);
+    hash_md5_finalize(s);
+    return read ? hash_md5_hexdigest(s, buffer) : "";
 }
 
 HASH_INLINE const char* hash_md5_easy(const char* str)
@@ -1335,7 +2454,7 @@ HASH_INLINE const char* hash_md5_easy(const char* str)
 
 HASH_INLINE const char* hash_md5_file_easy(const char* path, const char* mode)
 {
-    return hash_util_hash_file(path, mode, hash_md5_binary, NULL);
+    return hash_md5_file(path, mode, NULL);
 }
 #undef HASH_PRIVATE_MD5_BLOCKSIZE
 // =================================Hash_MD5====================================
@@ -1384,17 +2503,10 @@ namespace Hash
 
     namespace Util
     {
-        inline std::string CharArrayToHexString(unsigned char* data, size_t size)
+        inline std::string CharArrayToHexString(const unsigned char* data, size_t size)
         {
-            static const char hex_chars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
-            std::string string;
-            for (size_t i = 0; i < size; ++i)
-            {
-                char const byte = data[i];
-
-                string += hex_chars[(byte & 0xF0) >> 4];
-                string += hex_chars[(byte & 0x0F) >> 0];
-            }
+            std::string string(2 * size, '\0');
+            hash_private_hex_encode(data, size, &string[0]); // the terminating null lands on the string's own
             return string;
         }
 
@@ -1415,6 +2527,41 @@ namespace Hash
         }
 
 
+        // calls consume(const char* data, std::size_t size) for the whole file with constant memory, returns false if the file can't be read
+        template <typename F>
+        inline bool ReadFile(const char* path, std::ios::openmode flag, F consume)
+        {
+#if HASH_PRIVATE_MMAP != 0
+            Hash_Private_File_Map map;
+            if (hash_private_file_map(path, (flag & std::ios::binary) != 0, &map))
+            {
+                for (std::size_t i = 0; i < map.size; i += HASH_PRIVATE_FILE_SLICE)
+                    consume(&map.data[i], std::min<std::size_t>(map.size - i, HASH_PRIVATE_FILE_SLICE));
+                hash_private_file_unmap(&map);
+                return true;
+            }
+#endif
+            std::ifstream infile(path, flag);
+            if (!infile.is_open())
+                return false;
+
+            char chunk[HASH_FILE_CHUNK_SIZE];
+            while (infile.read(chunk, sizeof(chunk)) || infile.gcount() > 0)
+                consume(chunk, (std::size_t)infile.gcount());
+            return !infile.bad();
+        }
+
+
+        // streams the file through h.Update, a file that can't be read hashes like an empty one
+        template <typename H>
+        inline std::string HashFile(H h, const char* path, std::ios::openmode flag)
+        {
+            ReadFile(path, flag, [&h](const char* data, std::size_t size) { h.Update(data, size); });
+            h.Finalize();
+            return h.Hexdigest();
+        }
+
+
         template <typename T>
         constexpr T SwapEndian(T u)
         {
@@ -1448,6 +2595,21 @@ namespace Hash
             return (n >> c) | (n << (std::numeric_limits<T>::digits - c));
         }
 
+        // block b of str padded with 0x80 and zeros as 16 big endian words, the caller adds the length
+        template <typename T> constexpr void LoadPaddedBlock(std::string_view str, std::size_t b, T* w)
+        {
+            for (std::size_t i = 0; i < 16; ++i)
+            {
+                w[i] = 0;
+                for (std::size_t k = 0; k < sizeof(T); ++k)
+                {
+                    const std::size_t pos = 16 * sizeof(T) * b + sizeof(T) * i + k;
+                    const uint8_t byte = pos < str.size() ? (uint8_t)str[pos] : pos == str.size() ? 0b10000000 : 0;
+                    w[i] = (T)((w[i] << 8) | byte);
+                }
+            }
+        }
+
         template <typename T> constexpr T LeftRotate(T n, unsigned int c)
         {
             //const unsigned int mask = (CHAR_BIT * sizeof(n) - 1); // doesn't loose bits
@@ -1491,16 +2653,17 @@ namespace Hash
             0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
         };
     private:
-        inline void Compress(const uint32_t* const w)
+        // static constexpr so that sha256_ct can use the same rounds at compile time
+        static constexpr void Compress(uint32_t* const H, const uint32_t* const w)
         {
-            uint32_t a = m_H[0];
-            uint32_t b = m_H[1];
-            uint32_t c = m_H[2];
-            uint32_t d = m_H[3];
-            uint32_t e = m_H[4];
-            uint32_t f = m_H[5];
-            uint32_t g = m_H[6];
-            uint32_t h = m_H[7];
+            uint32_t a = H[0];
+            uint32_t b = H[1];
+            uint32_t c = H[2];
+            uint32_t d = H[3];
+            uint32_t e = H[4];
+            uint32_t f = H[5];
+            uint32_t g = H[6];
+            uint32_t h = H[7];
             for (size_t i = 0; i < 64; ++i)
             {
                 const uint32_t s1 = Util::RightRotate(e, 6) ^ Util::RightRotate(e, 11) ^ Util::RightRotate(e, 25);
@@ -1518,38 +2681,53 @@ namespace Hash
                 b = a;
                 a = temp1 + temp2;
             }
-            m_H[0] += a;
-            m_H[1] += b;
-            m_H[2] += c;
-            m_H[3] += d;
-            m_H[4] += e;
-            m_H[5] += f;
-            m_H[6] += g;
-            m_H[7] += h;
+            H[0] += a;
+            H[1] += b;
+            H[2] += c;
+            H[3] += d;
+            H[4] += e;
+            H[5] += f;
+            H[6] += g;
+            H[7] += h;
         }
 
 
-        inline void Transform()
+        // extends the first 16 words of w to the 64 word message schedule
+        static constexpr void Expand(uint32_t* const w)
         {
-            static uint32_t w[64];
-            for (size_t i = 0; i < 16; ++i)
-            {
-                uint8_t* c = (uint8_t*)&w[i];
-                c[0] = m_Buffer[4 * i];
-                c[1] = m_Buffer[4 * i + 1];
-                c[2] = m_Buffer[4 * i + 2];
-                c[3] = m_Buffer[4 * i + 3];
-                w[i] = Util::IsLittleEndian() ? Util::SwapEndian(w[i]) : w[i];
-            }
-
             for (size_t i = 16; i < 64; ++i)
             {
                 const uint32_t s0 = Util::RightRotate(w[i - 15], 7) ^ Util::RightRotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
                 const uint32_t s1 = Util::RightRotate(w[i - 2], 17) ^ Util::RightRotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
                 w[i] = w[i - 16] + s0 + w[i - 7] + s1;
             }
-            Compress(w);
         }
+
+
+        inline void Transform(const uint8_t* block)
+        {
+#if HASH_PRIVATE_SHA256_ACCEL == 1
+            if (hash_private_sha256_accel_supported())
+            {
+                hash_private_sha256_accel_transform(m_H, block);
+                return;
+            }
+#endif
+            uint32_t w[64];
+            for (size_t i = 0; i < 16; ++i)
+            {
+                uint8_t* c = (uint8_t*)&w[i];
+                c[0] = block[4 * i];
+                c[1] = block[4 * i + 1];
+                c[2] = block[4 * i + 2];
+                c[3] = block[4 * i + 3];
+                w[i] = Util::IsLittleEndian() ? Util::SwapEndian(w[i]) : w[i];
+            }
+            Expand(w);
+            Compress(m_H, w);
+        }
+
+        friend constexpr std::array<uint8_t, 32> sha256_ct(std::string_view str);
     public:
         Sha256() = default;
         explicit Sha256(uint32_t h0, uint32_t h1, uint32_t h2, uint32_t h3, uint32_t h4, uint32_t h5, uint32_t h6, uint32_t h7) : m_H{ h0, h1, h2, h3, h4, h5, h6, h7 } {}
@@ -1557,16 +2735,33 @@ namespace Hash
 
         inline void Update(const uint8_t* data, std::size_t size)
         {
-            for (size_t i = 0; i < size; ++i)
+            // fill up a partially filled block first
+            if (m_BufferSize != 0)
             {
-                m_Buffer[m_BufferSize++] = data[i];
-                if (m_BufferSize == 64)
-                {
-                    Transform();
-                    m_BufferSize = 0;
-                    m_Bitlen += 512;
-                }
+                const std::size_t fill = std::min<std::size_t>(size, 64 - m_BufferSize);
+                std::memcpy(&m_Buffer[m_BufferSize], data, fill);
+                m_BufferSize += (uint8_t)fill;
+                data += fill;
+                size -= fill;
+
+                if (m_BufferSize < 64)
+                    return;
+
+                Transform(m_Buffer);
+                m_BufferSize = 0;
+                m_Bitlen += 512;
+            }
+
+            // compress whole blocks directly from the input, no copy into the buffer
+            for (; size >= 64; data += 64, size -= 64)
+            {
+                Transform(data);
+                m_Bitlen += 512;
             }
+
+            // buffer the remaining tail
+            std::memcpy(m_Buffer, data, size);
+            m_BufferSize = (uint8_t)size;
         }
 
         inline void Update(const char* data, std::size_t size)
@@ -1590,26 +2785,58 @@ namespace Hash
 
             if (m_BufferSize >= 56)
             {
-                Transform();
+                Transform(m_Buffer);
                 std::memset(m_Buffer, 0, 56);
             }
 
             m_Bitlen += m_BufferSize * 8;
             uint64_t* const size = (uint64_t*)&m_Buffer[64 - 8];
             *size = Util::IsLittleEndian() ? Util::SwapEndian(m_Bitlen) : m_Bitlen;
-            Transform();
+            Transform(m_Buffer);
         }
 
 
+        // the raw digest in big endian byte order, out must hold 32 bytes
+        inline virtual void Digest(uint8_t* out) const
+        {
+            for (std::size_t i = 0; i < 32; ++i)
+                out[i] = (uint8_t)(m_H[i / 4] >> (24 - 8 * (i % 4)));
+        }
+
         inline virtual std::string Hexdigest() const
         {
-            std::stringstream stream;
-            stream << std::hex << std::setfill('0') << std::setw(8) << m_H[0] << std::setw(8) << m_H[1] << std::setw(8) << m_H[2] << std::setw(8) << m_H[3] << std::setw(8) << m_H[4] << std::setw(8) << m_H[5] << std::setw(8) << m_H[6] << std::setw(8) << m_H[7];
-            return stream.str();
+            uint8_t digest[32];
+            Sha256::Digest(digest);
+            return Util::CharArrayToHexString(digest, 32);
         }
     };
 
 
+    // compile time sha256 of str as raw digest, e.g. constexpr auto digest = Hash::sha256_ct("password");
+    constexpr std::array<uint8_t, 32> sha256_ct(std::string_view str)
+    {
+        uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        uint32_t w[64] = {};
+        const uint64_t bitlen = (uint64_t)str.size() * 8;
+        const std::size_t blocks = (str.size() + 9 + 63) / 64; // room for the 0x80 byte and the 64 bit length
+        for (std::size_t b = 0; b < blocks; ++b)
+        {
+            Util::LoadPaddedBlock(str, b, w);
+            if (b == blocks - 1)
+            {
+                w[14] = (uint32_t)(bitlen >> 32);
+                w[15] = (uint32_t)bitlen;
+            }
+            Sha256::Expand(w);
+            Sha256::Compress(h, w);
+        }
+
+        std::array<uint8_t, 32> digest = {};
+        for (std::size_t i = 0; i < 32; ++i)
+            digest[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+        return digest;
+    }
+
     // if you have any kind of unicode string, use the Hash::encode functions beforehand to convert the string
     inline std::string sha256(const char* str, std::size_t size)
     {
@@ -1628,12 +2855,12 @@ namespace Hash
     {
         inline std::string sha256(const char* path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha256(Util::LoadFile(path, flag));
+            return Util::HashFile(Sha256(), path, flag);
         }
 
         inline std::string sha256(std::string_view path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha256(Util::LoadFile(path.data(), flag));
+            return Util::HashFile(Sha256(), path.data(), flag);
         }
     }
 
@@ -1643,11 +2870,18 @@ namespace Hash
     {
     public:
         Sha224() : Sha256(0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939, 0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4) {}
+        // out must hold 28 bytes
+        inline void Digest(uint8_t* out) const override
+        {
+            for (std::size_t i = 0; i < 28; ++i)
+                out[i] = (uint8_t)(m_H[i / 4] >> (24 - 8 * (i % 4)));
+        }
+
         inline std::string Hexdigest() const override
         {
-            std::stringstream stream;
-            stream << std::hex << std::setfill('0') << std::setw(8) << m_H[0] << std::setw(8) << m_H[1] << std::setw(8) << m_H[2] << std::setw(8) << m_H[3] << std::setw(8) << m_H[4] << std::setw(8) << m_H[5] << std::setw(8) << m_H[6];
-            return stream.str();
+            uint8_t digest[28];
+            Sha224::Digest(digest);
+            return Util::CharArrayToHexString(digest, 28);
         }
     };
 
@@ -1670,12 +2904,12 @@ namespace Hash
     {
         inline std::string sha224(const char* path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha224(Util::LoadFile(path, flag));
+            return Util::HashFile(Sha224(), path, flag);
         }
 
         inline std::string sha224(std::string_view path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha224(Util::LoadFile(path.data(), flag));
+            return Util::HashFile(Sha224(), path.data(), flag);
         }
     }
 
@@ -1721,17 +2955,18 @@ namespace Hash
             0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
             0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
         };
-    private:
-        inline void Compress(const uint64_t* const w)
-        {
-            uint64_t a = m_H[0];
-            uint64_t b = m_H[1];
-            uint64_t c = m_H[2];
-            uint64_t d = m_H[3];
-            uint64_t e = m_H[4];
-            uint64_t f = m_H[5];
-            uint64_t g = m_H[6];
-            uint64_t h = m_H[7];
+    protected:
+        // constexpr so that Sha512T can derive its initial values at compile time
+        static constexpr void Compress(uint64_t* const H, const uint64_t* const w)
+        {
+            uint64_t a = H[0];
+            uint64_t b = H[1];
+            uint64_t c = H[2];
+            uint64_t d = H[3];
+            uint64_t e = H[4];
+            uint64_t f = H[5];
+            uint64_t g = H[6];
+            uint64_t h = H[7];
             for (size_t i = 0; i < 80; ++i)
             {
                 const uint64_t s1 = Util::RightRotate(e, 14) ^ Util::RightRotate(e, 18) ^ Util::RightRotate(e, 41);
@@ -1749,42 +2984,51 @@ namespace Hash
                 b = a;
                 a = temp1 + temp2;
             }
-            m_H[0] += a;
-            m_H[1] += b;
-            m_H[2] += c;
-            m_H[3] += d;
-            m_H[4] += e;
-            m_H[5] += f;
-            m_H[6] += g;
-            m_H[7] += h;
+            H[0] += a;
+            H[1] += b;
+            H[2] += c;
+            H[3] += d;
+            H[4] += e;
+            H[5] += f;
+            H[6] += g;
+            H[7] += h;
         }
 
 
-        inline void Transform()
+        // extends the first 16 words of w to the 80 word message schedule
+        static constexpr void Expand(uint64_t* const w)
         {
-            static uint64_t w[80];
-            for (size_t i = 0; i < 16; ++i)
-            {
-                uint8_t* c = (uint8_t*)&w[i];
-                c[0] = m_Buffer[8 * i];
-                c[1] = m_Buffer[8 * i + 1];
-                c[2] = m_Buffer[8 * i + 2];
-                c[3] = m_Buffer[8 * i + 3];
-                c[4] = m_Buffer[8 * i + 4];
-                c[5] = m_Buffer[8 * i + 5];
-                c[6] = m_Buffer[8 * i + 6];
-                c[7] = m_Buffer[8 * i + 7];
-                w[i] = Util::IsLittleEndian() ? Util::SwapEndian(w[i]) : w[i];
-            }
-
-            for (size_t i = 16; i < 80; ++i) // Extend the first 16 words
+            for (size_t i = 16; i < 80; ++i)
             {
                 const uint64_t s0 = Util::RightRotate(w[i - 15], 1) ^ Util::RightRotate(w[i - 15], 8) ^ (w[i - 15] >> 7);
                 const uint64_t s1 = Util::RightRotate(w[i - 2], 19) ^ Util::RightRotate(w[i - 2], 61) ^ (w[i - 2] >> 6);
                 w[i] = w[i - 16] + s0 + w[i - 7] + s1;
             }
-            Compress(w);
         }
+    private:
+
+
+        inline void Transform(const uint8_t* block)
+        {
+            uint64_t w[80];
+            for (size_t i = 0; i < 16; ++i)
+            {
+                uint8_t* c = (uint8_t*)&w[i];
+                c[0] = block[8 * i];
+                c[1] = block[8 * i + 1];
+                c[2] = block[8 * i + 2];
+                c[3] = block[8 * i + 3];
+                c[4] = block[8 * i + 4];
+                c[5] = block[8 * i + 5];
+                c[6] = block[8 * i + 6];
+                c[7] = block[8 * i + 7];
+                w[i] = Util::IsLittleEndian() ? Util::SwapEndian(w[i]) : w[i];
+            }
+            Expand(w);
+            Compress(m_H, w);
+        }
+
+        friend constexpr std::array<uint8_t, 64> sha512_ct(std::string_view str);
     public:
         Sha512() = default;
         explicit Sha512(uint64_t h0, uint64_t h1, uint64_t h2, uint64_t h3, uint64_t h4, uint64_t h5, uint64_t h6, uint64_t h7) : m_H{ h0, h1, h2, h3, h4, h5, h6, h7 } {}
@@ -1798,16 +3042,33 @@ namespace Hash
 
         inline void Update(const uint8_t* data, std::size_t size)
         {
-            for (size_t i = 0; i < size; ++i)
+            // fill up a partially filled block first
+            if (m_BufferSize != 0)
             {
-                m_Buffer[m_BufferSize++] = data[i];
-                if (m_BufferSize == 128)
-                {
-                    Transform();
-                    m_BufferSize = 0;
-                    m_Bitlen += 1024;
-                }
+                const std::size_t fill = std::min<std::size_t>(size, 128 - m_BufferSize);
+                std::memcpy(&m_Buffer[m_BufferSize], data, fill);
+                m_BufferSize += (uint8_t)fill;
+                data += fill;
+                size -= fill;
+
+                if (m_BufferSize < 128)
+                    return;
+
+                Transform(m_Buffer);
+                m_BufferSize = 0;
+                m_Bitlen += 1024;
+            }
+
+            // compress whole blocks directly from the input, no copy into the buffer
+            for (; size >= 128; data += 128, size -= 128)
+            {
+                Transform(data);
+                m_Bitlen += 1024;
             }
+
+            // buffer the remaining tail
+            std::memcpy(m_Buffer, data, size);
+            m_BufferSize = (uint8_t)size;
         }
 
         inline void Update(const char* data, std::size_t size)
@@ -1831,52 +3092,212 @@ namespace Hash
 
             if (m_BufferSize >= 112)
             {
-                Transform();
+                Transform(m_Buffer);
                 std::memset(m_Buffer, 0, 120);
             }
 
             m_Bitlen += m_BufferSize * 8;
             uint64_t* const size = (uint64_t*)&m_Buffer[128 - 8]; // -8 instead of -16 because we use an uint64 instead of uint128
             *size = Util::IsLittleEndian() ? Util::SwapEndian(m_Bitlen) : m_Bitlen;
-            Transform();
+            Transform(m_Buffer);
+        }
+
+
+        // the raw digest in big endian byte order, out must hold 64 bytes
+        inline virtual void Digest(uint8_t* out) const
+        {
+            for (std::size_t i = 0; i < 64; ++i)
+                out[i] = (uint8_t)(m_H[i / 8] >> (56 - 8 * (i % 8)));
+        }
+
+        inline virtual std::string Hexdigest() const
+        {
+            uint8_t digest[64];
+            Sha512::Digest(digest);
+            return Util::CharArrayToHexString(digest, 64);
+        }
+    };
+
+
+    // compile time sha512 of str as raw digest, e.g. constexpr auto digest = Hash::sha512_ct("password");
+    constexpr std::array<uint8_t, 64> sha512_ct(std::string_view str)
+    {
+        uint64_t h[8] = { 0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1, 0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179 };
+        uint64_t w[80] = {};
+        const std::size_t blocks = (str.size() + 17 + 127) / 128; // room for the 0x80 byte and the 128 bit length
+        for (std::size_t b = 0; b < blocks; ++b)
+        {
+            Util::LoadPaddedBlock(str, b, w);
+            if (b == blocks - 1)
+                w[15] = (uint64_t)str.size() * 8;
+            Sha512::Expand(w);
+            Sha512::Compress(h, w);
+        }
+
+        std::array<uint8_t, 64> digest = {};
+        for (std::size_t i = 0; i < 64; ++i)
+            digest[i] = (uint8_t)(h[i / 8] >> (56 - 8 * (i % 8)));
+        return digest;
+    }
+
+    // if you have any kind of unicode string, use the Hash::encode functions beforehand to convert the string
+    inline std::string sha512(const char* str, std::size_t size)
+    {
+        Sha512 s;
+        s.Update(str, size);
+        s.Finalize();
+        return s.Hexdigest();
+    }
+
+    inline std::string sha512(std::string_view str)
+    {
+        return sha512(str.data(), str.size());
+    }
+
+    namespace File
+    {
+        inline std::string sha512(const char* path, std::ios::openmode flag = std::ios::binary)
+        {
+            return Util::HashFile(Sha512(), path, flag);
+        }
+
+        inline std::string sha512(std::string_view path, std::ios::openmode flag = std::ios::binary)
+        {
+            return Util::HashFile(Sha512(), path.data(), flag);
+        }
+    }
+
+    // hashes count independent messages at once (fast for many short messages), digests must hold count * 64 bytes
+    // the raw digests are written in big endian order: message i at digests[64 * i]
+    inline void sha512_batch(const std::string_view* messages, std::size_t count, uint8_t* digests)
+    {
+        const char* data[8];
+        std::size_t sizes[8];
+        for (std::size_t i = 0; i < count; i += 8)
+        {
+            const std::size_t n = std::min<std::size_t>(8, count - i);
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                data[k] = messages[i + k].data();
+                sizes[k] = messages[i + k].size();
+            }
+            hash_private_sha512_mb(data, sizes, n, &digests[64 * i]);
         }
+    }
+
+#if HASH_SHA512_TREE == 1
+    namespace File
+    {
+        // tree hash for very large files, the chunks are hashed on worker threads so it scales with the number of cores
+        // leaf i = sha512(chunk i), root = sha512(chunkSize || fileSize || leaf 0 || leaf 1 || ...) with the sizes as 64 bit big endian
+        // this is not the sha512 of the file, returns "sha512-tree:<chunkSize>:<root>" or "" if the file can't be read
+        // threads == 0 uses all cores
+        inline std::string sha512_tree(const char* path, std::size_t chunkSize = HASH_SHA512_TREE_CHUNK_SIZE, unsigned int threads = 0)
+        {
+            std::ifstream infile(path, std::ios::binary | std::ios::ate);
+            if (!infile.is_open() || chunkSize == 0)
+                return "";
+            const uint64_t fileSize = (uint64_t)infile.tellg();
+            infile.close();
+
+            const std::size_t leaves = fileSize == 0 ? 1 : (std::size_t)((fileSize + chunkSize - 1) / chunkSize);
+            std::vector<uint8_t> digests(leaves * 64);
+
+            bool mapped = false;
+#if HASH_PRIVATE_MMAP != 0
+            Hash_Private_File_Map map;
+            if (fileSize != 0 && hash_private_file_map(path, 1, &map))
+            {
+                mapped = map.size == fileSize;
+                if (!mapped) // changed since we got the size
+                    hash_private_file_unmap(&map);
+            }
+#endif
+
+            std::atomic<std::size_t> next(0);
+            std::atomic<bool> failed(false);
+            auto worker = [&]()
+            {
+                std::ifstream in;
+                if (!mapped)
+                {
+                    in.open(path, std::ios::binary);
+                    if (!in.is_open())
+                    {
+                        failed = true;
+                        return;
+                    }
+                }
+
+                char chunk[HASH_FILE_CHUNK_SIZE];
+                for (std::size_t i = next++; i < leaves && !failed; i = next++)
+                {
+                    const uint64_t offset = (uint64_t)i * chunkSize;
+                    const uint64_t size = std::min<uint64_t>(chunkSize, fileSize - offset);
 
+                    Sha512 leaf;
+#if HASH_PRIVATE_MMAP != 0
+                    if (mapped)
+                        leaf.Update(&map.data[offset], (std::size_t)size);
+#endif
+                    if (!mapped)
+                    {
+                        in.seekg((std::streamoff)offset);
+                        for (uint64_t read = 0; read < size;)
+                        {
+                            const std::size_t n = (std::size_t)std::min<uint64_t>(sizeof(chunk), size - read);
+                            if (!in.read(chunk, n))
+                            {
+                                failed = true;
+                                return;
+                            }
+                            leaf.Update(chunk, n);
+                            read += n;
+                        }
+                    }
+                    leaf.Finalize();
+                    leaf.Digest(&digests[64 * i]);
+                }
+            };
 
-        inline virtual std::string Hexdigest() const
-        {
-            std::stringstream stream;
-            stream << std::hex << std::setfill('0') << std::setw(16) << m_H[0] << std::setw(16) << m_H[1] << std::setw(16) << m_H[2] << std::setw(16) << m_H[3] << std::setw(16) << m_H[4] << std::setw(16) << m_H[5] << std::setw(16) << m_H[6] << std::setw(16) << m_H[7];
-            return stream.str();
-        }
-    };
+            if (threads == 0)
+                threads = std::max(std::thread::hardware_concurrency(), 1u);
+            threads = (unsigned int)std::min<std::size_t>(threads, leaves);
 
+            std::vector<std::thread> workers;
+            for (unsigned int i = 1; i < threads; ++i)
+                workers.emplace_back(worker);
+            worker(); // the calling thread works too
+            for (std::thread& t : workers)
+                t.join();
 
-    // if you have any kind of unicode string, use the Hash::encode functions beforehand to convert the string
-    inline std::string sha512(const char* str, std::size_t size)
-    {
-        Sha512 s;
-        s.Update(str, size);
-        s.Finalize();
-        return s.Hexdigest();
-    }
+#if HASH_PRIVATE_MMAP != 0
+            if (mapped)
+                hash_private_file_unmap(&map);
+#endif
+            if (failed)
+                return "";
 
-    inline std::string sha512(std::string_view str)
-    {
-        return sha512(str.data(), str.size());
-    }
+            uint8_t header[16];
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                header[i] = (uint8_t)((uint64_t)chunkSize >> (56 - 8 * i));
+                header[8 + i] = (uint8_t)(fileSize >> (56 - 8 * i));
+            }
 
-    namespace File
-    {
-        inline std::string sha512(const char* path, std::ios::openmode flag = std::ios::binary)
-        {
-            return Hash::sha512(Util::LoadFile(path, flag));
+            Sha512 root;
+            root.Update(header, sizeof(header));
+            root.Update(digests.data(), digests.size());
+            root.Finalize();
+            return "sha512-tree:" + std::to_string(chunkSize) + ":" + root.Hexdigest();
         }
 
-        inline std::string sha512(std::string_view path, std::ios::openmode flag = std::ios::binary)
+        inline std::string sha512_tree(std::string_view path, std::size_t chunkSize = HASH_SHA512_TREE_CHUNK_SIZE, unsigned int threads = 0)
         {
-            return Hash::sha512(Util::LoadFile(path.data(), flag));
+            return sha512_tree(path.data(), chunkSize, threads);
         }
     }
+#endif // HASH_SHA512_TREE
 
 
 
@@ -1886,35 +3307,60 @@ namespace Hash
     {
     private:
         size_t m_T;
-    private:
-        inline std::string HexdigestFull() const
+    protected:
+        // the sha512 of "SHA-512/t" with modified initial values (FIPS 180-4 5.3.6), built in for t = 224 and t = 256
+        static constexpr std::array<uint64_t, 8> InitialValues(size_t t)
         {
-            return Sha512::Hexdigest();
+            if (t == 224)
+                return { 0x8c3d37c819544da2, 0x73e1996689dcd4d6, 0x1dfab7ae32ff9c82, 0x679dd514582f9fcf, 0x0f6d2b697bd44da8, 0x77e36f7304c48942, 0x3f9d85a86a1d36c8, 0x1112e6ad91d692a1 };
+            if (t == 256)
+                return { 0x22312194fc2bf72c, 0x9f555fa3c84c64c2, 0x2393b86b6f53b151, 0x963877195940eabd, 0x96283ee2a88effe3, 0xbe5e1e2553863992, 0x2b0199fc2c85b8aa, 0x0eb72ddc81c52ca2 };
+
+            std::array<uint64_t, 8> h = { 0xcfac43c256196cad, 0x1ec20b20216f029e, 0x99cb56d75b315d8e, 0x00ea509ffab89354, 0xf4abf7da08432774, 0x3ea0cd298e9bc9ba, 0xba267c0e5ee418ce, 0xfe4568bcb6db84dc };
+
+            // "SHA-512/t" always fits into a single padded block
+            uint8_t block[128] = { 'S', 'H', 'A', '-', '5', '1', '2', '/' };
+            size_t digits = 1;
+            for (size_t n = t; n >= 10; n /= 10)
+                digits++;
+            for (size_t i = 0, n = t; i < digits; ++i, n /= 10)
+                block[8 + digits - 1 - i] = (uint8_t)('0' + n % 10);
+            const size_t size = 8 + digits;
+            block[size] = 0b10000000;
+
+            uint64_t w[80] = {};
+            for (size_t i = 0; i < 15; ++i)
+                for (size_t k = 0; k < 8; ++k)
+                    w[i] = (w[i] << 8) | block[8 * i + k];
+            w[15] = size * 8;
+            Expand(w);
+            Compress(h.data(), w);
+            return h;
         }
+
+        inline Sha512T(size_t t, const std::array<uint64_t, 8>& h) : Sha512(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]), m_T(t) {}
     public:
-        inline explicit Sha512T(size_t t) : Sha512(0xcfac43c256196cad, 0x1ec20b20216f029e, 0x99cb56d75b315d8e, 0x00ea509ffab89354, 0xf4abf7da08432774, 0x3ea0cd298e9bc9ba, 0xba267c0e5ee418ce, 0xfe4568bcb6db84dc), m_T(t)
+        inline explicit Sha512T(size_t t) : Sha512T(t, InitialValues(t))
         {
             assert(t != 384 && "t = 384 is not allowed use Sha384 instead!");
             assert(t >= 4 && t <= 2048 && "t must satisfy t >= 4 && t <= 2048!");
+        }
 
-            std::string s = "SHA-512/" + std::to_string(m_T);
-            Update(s);
-            Finalize();
-            s = HexdigestFull();
-            Reset();
-
-            size_t k = 0;
-            for (size_t i = 0; i < s.size(); i += 16)
-            {
-                std::stringstream ss;
-                ss << std::hex << std::string_view(&s.c_str()[i], 16);
-                ss >> m_H[k++];
-            }
+        // the leftmost t bits, out must hold (t+7)/8 bytes (at most 64)
+        inline void Digest(uint8_t* out) const override
+        {
+            const std::size_t t = std::min<std::size_t>(m_T, 512);
+            for (std::size_t i = 0; i < (t + 7) / 8; ++i)
+                out[i] = (uint8_t)(m_H[i / 8] >> (56 - 8 * (i % 8)));
+            if (t % 8 != 0)
+                out[t / 8] &= (uint8_t)(0xff << (8 - t % 8));
         }
 
         inline std::string Hexdigest() const override
         {
-            return Sha512::Hexdigest().substr(0, m_T / 4);
+            uint8_t digest[64];
+            Sha512::Digest(digest);
+            return Util::CharArrayToHexString(digest, 64).substr(0, m_T / 4);
         }
     };
 
@@ -1923,9 +3369,11 @@ namespace Hash
     class Sha512_T : public Sha512T
     {
         static_assert(T != 384, "T = 384 is not allowed use Sha384 instead!");
-        static_assert(T >= 4 && T <= 2048 * 4, "T must satisfy T >= 4 && T <= 2048!");
+        static_assert(T >= 4 && T <= 2048, "T must satisfy T >= 4 && T <= 2048!");
+    private:
+        static constexpr std::array<uint64_t, 8> s_H = InitialValues(T); // evaluated at compile time
     public:
-        inline Sha512_T() : Sha512T(T) {}
+        inline Sha512_T() : Sha512T(T, s_H) {}
     };
     using Sha512_224 = Sha512_T<224>;
     using Sha512_256 = Sha512_T<256>;
@@ -1964,10 +3412,10 @@ namespace Hash
 
     namespace File
     {
-        inline std::string sha512t(size_t t, const char* path, std::ios::openmode flag = std::ios::binary) { return Hash::sha512t(t, Util::LoadFile(path, flag)); }
-        inline std::string sha512t(size_t t, std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha512t(t, Util::LoadFile(path.data(), flag)); }
-        template <size_t T> inline std::string sha512t(const char* path, std::ios::openmode flag = std::ios::binary) { return Hash::sha512t<T>(Util::LoadFile(path, flag)); }
-        template <size_t T> inline std::string sha512t(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha512t<T>(Util::LoadFile(path.data(), flag)); }
+        inline std::string sha512t(size_t t, const char* path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha512T(t), path, flag); }
+        inline std::string sha512t(size_t t, std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha512T(t), path.data(), flag); }
+        template <size_t T> inline std::string sha512t(const char* path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha512_T<T>(), path, flag); }
+        template <size_t T> inline std::string sha512t(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha512_T<T>(), path.data(), flag); }
 
         inline std::string sha512_224(const char* path, std::ios::openmode flag = std::ios::binary) { return sha512t<224>(path, flag); }
         inline std::string sha512_256(const char* path, std::ios::openmode flag = std::ios::binary) { return sha512t<256>(path, flag); }
@@ -1983,11 +3431,18 @@ namespace Hash
     {
     public:
         Sha384() : Sha512(0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17, 0x152fecd8f70e5939, 0x67332667ffc00b31, 0x8eb44a8768581511, 0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4) {}
+        // out must hold 48 bytes
+        inline void Digest(uint8_t* out) const override
+        {
+            for (std::size_t i = 0; i < 48; ++i)
+                out[i] = (uint8_t)(m_H[i / 8] >> (56 - 8 * (i % 8)));
+        }
+
         inline std::string Hexdigest() const override
         {
-            std::stringstream stream;
-            stream << std::hex << std::setfill('0') << std::setw(16) << m_H[0] << std::setw(16) << m_H[1] << std::setw(16) << m_H[2] << std::setw(16) << m_H[3] << std::setw(16) << m_H[4] << std::setw(16) << m_H[5];
-            return stream.str();
+            uint8_t digest[48];
+            Sha384::Digest(digest);
+            return Util::CharArrayToHexString(digest, 48);
         }
     };
 
@@ -2010,12 +3465,12 @@ namespace Hash
     {
         inline std::string sha384(const char* path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha384(Util::LoadFile(path, flag));
+            return Util::HashFile(Sha384(), path, flag);
         }
 
         inline std::string sha384(std::string_view path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha384(Util::LoadFile(path.data(), flag));
+            return Util::HashFile(Sha384(), path.data(), flag);
         }
     }
 #endif // HASH_ENABLE_SHA2
@@ -2148,11 +3603,18 @@ namespace Hash
         }
 
 
+        // the raw digest in big endian byte order, out must hold 20 bytes
+        inline void Digest(uint8_t* out) const
+        {
+            for (std::size_t i = 0; i < 20; ++i)
+                out[i] = (uint8_t)(m_H[i / 4] >> (24 - 8 * (i % 4)));
+        }
+
         inline std::string Hexdigest() const
         {
-            std::stringstream stream;
-            stream << std::hex << std::setfill('0') << std::setw(8) << m_H[0] << std::setw(8) << m_H[1] << std::setw(8) << m_H[2] << std::setw(8) << m_H[3] << std::setw(8) << m_H[4];
-            return stream.str();
+            uint8_t digest[20];
+            Digest(digest);
+            return Util::CharArrayToHexString(digest, 20);
         }
     };
 
@@ -2173,12 +3635,12 @@ namespace Hash
     {
         inline std::string sha1(const char* path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha1(Util::LoadFile(path, flag));
+            return Util::HashFile(Sha1(), path, flag);
         }
 
         inline std::string sha1(std::string_view path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::sha1(Util::LoadFile(path.data(), flag));
+            return Util::HashFile(Sha1(), path.data(), flag);
         }
     }
 #endif // HASH_ENABLE_SHA1
@@ -2377,12 +3839,7 @@ namespace Hash
             if (!finalized)
                 return "";
 
-            char buf[33];
-            for (int i = 0; i < 16; i++)
-                sprintf(buf + i * 2, "%02x", digest[i]);
-            buf[32] = 0;
-
-            return std::string(buf);
+            return Util::CharArrayToHexString(digest, 16);
         }
 
         friend std::ostream& operator<<(std::ostream&, const MD5& md5);
@@ -2579,12 +4036,18 @@ namespace Hash
     {
         inline std::string md5(const char* path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::md5(Util::LoadFile(path, flag));
+            MD5 md5;
+            Util::ReadFile(path, flag, [&md5](const char* data, std::size_t size) { md5.update(data, (MD5::size_type)size); });
+            md5.finalize();
+            return md5.hexdigest();
         }
 
         inline std::string md5(std::string_view path, std::ios::openmode flag = std::ios::binary)
         {
-            return Hash::md5(Util::LoadFile(path.data(), flag));
+            MD5 md5;
+            Util::ReadFile(path.data(), flag, [&md5](const char* data, std::size_t size) { md5.update(data, (MD5::size_type)size); });
+            md5.finalize();
+            return md5.hexdigest();
         }
     }
     //=============================================================================
@@ -2670,6 +4133,109 @@ inline void hash_private_keccak_Keccak(unsigned int rate, unsigned int capacity,
 
 namespace Hash
 {
+    class Sha3
+    {
+    private:
+        Hash_Private_Keccak m_Keccak;
+    public:
+        // bits is the digest size: 224, 256, 384 or 512
+        inline explicit Sha3(std::size_t bits = 256)
+        {
+            assert((bits == 224 || bits == 256 || bits == 384 || bits == 512) && "bits must be 224, 256, 384 or 512!");
+            hash_private_keccak_init(&m_Keccak, 1600 - 2 * (unsigned int)bits, 0x06);
+        }
+
+        inline void Update(const uint8_t* data, std::size_t size)
+        {
+            hash_private_keccak_absorb(&m_Keccak, data, size);
+        }
+
+        inline void Update(const char* data, std::size_t size)
+        {
+            Update((const uint8_t*)data, size);
+        }
+
+        inline void Update(std::string_view data)
+        {
+            Update((const uint8_t*)data.data(), data.size());
+        }
+
+        inline void Finalize()
+        {
+            hash_private_keccak_finalize(&m_Keccak);
+        }
+
+        // the raw digest, out must hold bits / 8 bytes
+        inline void Digest(uint8_t* out) const
+        {
+            // the digest is half the capacity and fits in the first block of output
+            std::memcpy(out, m_Keccak.state, (200 - m_Keccak.rateInBytes) / 2);
+        }
+
+        inline std::string Hexdigest() const
+        {
+            return Util::CharArrayToHexString((const unsigned char*)m_Keccak.state, (200 - m_Keccak.rateInBytes) / 2);
+        }
+    };
+
+
+    class Shake
+    {
+    private:
+        Hash_Private_Keccak m_Keccak;
+    public:
+        // securityBits is 128 (shake128) or 256 (shake256)
+        inline explicit Shake(std::size_t securityBits = 256)
+        {
+            assert((securityBits == 128 || securityBits == 256) && "securityBits must be 128 or 256!");
+            hash_private_keccak_init(&m_Keccak, 1600 - 2 * (unsigned int)securityBits, 0x1F);
+        }
+
+        inline void Update(const uint8_t* data, std::size_t size)
+        {
+            hash_private_keccak_absorb(&m_Keccak, data, size);
+        }
+
+        inline void Update(const char* data, std::size_t size)
+        {
+            Update((const uint8_t*)data, size);
+        }
+
+        inline void Update(std::string_view data)
+        {
+            Update((const uint8_t*)data.data(), data.size());
+        }
+
+        // optional, the first squeeze finalizes, no more updates afterwards
+        inline void Finalize()
+        {
+            hash_private_keccak_finalize(&m_Keccak);
+        }
+
+        // the next size bytes of output, call it again for more
+        inline void Squeeze(uint8_t* out, std::size_t size)
+        {
+            hash_private_keccak_squeeze(&m_Keccak, out, size);
+        }
+
+        // the next outsizeBytes / 2 bytes of output as hex like the shake functions
+        inline std::string Hexsqueeze(std::size_t outsizeBytes)
+        {
+            std::string hex;
+            hex.reserve(outsizeBytes);
+            uint8_t buff[32];
+            for (std::size_t remaining = outsizeBytes / 2; remaining > 0;)
+            {
+                const std::size_t n = std::min<std::size_t>(remaining, sizeof(buff));
+                Squeeze(buff, n);
+                hex += Util::CharArrayToHexString(buff, n);
+                remaining -= n;
+            }
+            return hex;
+        }
+    };
+
+
     inline std::string shake128(const unsigned char* data, size_t size, size_t outsizeBytes)
     {
         std::string buff(outsizeBytes / 2, ' ');
@@ -2716,15 +4282,22 @@ namespace Hash
 
     namespace File
     {
-        inline std::string shake128(const char* path,      size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return Hash::shake128(Util::LoadFile(path, flag),        outsizeBytes); }
-        inline std::string shake128(std::string_view path, size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return Hash::shake128(Util::LoadFile(path.data(), flag), outsizeBytes); }
-        inline std::string shake256(const char* path,      size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return Hash::shake256(Util::LoadFile(path, flag),        outsizeBytes); }
-        inline std::string shake256(std::string_view path, size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return Hash::shake256(Util::LoadFile(path.data(), flag), outsizeBytes); }
+        inline std::string shake(std::size_t securityBits, const char* path, size_t outsizeBytes, std::ios::openmode flag)
+        {
+            Shake s(securityBits);
+            Util::ReadFile(path, flag, [&s](const char* data, std::size_t size) { s.Update(data, size); });
+            return s.Hexsqueeze(outsizeBytes);
+        }
 
-        template <size_t outsizeBytes> inline std::string shake128(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::shake128<outsizeBytes>(Util::LoadFile(path,        flag)); }
-        template <size_t outsizeBytes> inline std::string shake128(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::shake128<outsizeBytes>(Util::LoadFile(path.data(), flag)); }
-        template <size_t outsizeBytes> inline std::string shake256(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::shake256<outsizeBytes>(Util::LoadFile(path,        flag)); }
-        template <size_t outsizeBytes> inline std::string shake256(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::shake256<outsizeBytes>(Util::LoadFile(path.data(), flag)); }
+        inline std::string shake128(const char* path,      size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return shake(128, path,        outsizeBytes, flag); }
+        inline std::string shake128(std::string_view path, size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return shake(128, path.data(), outsizeBytes, flag); }
+        inline std::string shake256(const char* path,      size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return shake(256, path,        outsizeBytes, flag); }
+        inline std::string shake256(std::string_view path, size_t outsizeBytes, std::ios::openmode flag = std::ios::binary) { return shake(256, path.data(), outsizeBytes, flag); }
+
+        template <size_t outsizeBytes> inline std::string shake128(const char* path,      std::ios::openmode flag = std::ios::binary) { return shake(128, path,        outsizeBytes, flag); }
+        template <size_t outsizeBytes> inline std::string shake128(std::string_view path, std::ios::openmode flag = std::ios::binary) { return shake(128, path.data(), outsizeBytes, flag); }
+        template <size_t outsizeBytes> inline std::string shake256(const char* path,      std::ios::openmode flag = std::ios::binary) { return shake(256, path,        outsizeBytes, flag); }
+        template <size_t outsizeBytes> inline std::string shake256(std::string_view path, std::ios::openmode flag = std::ios::binary) { return shake(256, path.data(), outsizeBytes, flag); }
     }
 
 
@@ -2771,14 +4344,14 @@ namespace Hash
 
     namespace File
     {
-        inline std::string sha3_224(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::sha3_224(Util::LoadFile(path,        flag)); }
-        inline std::string sha3_224(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha3_224(Util::LoadFile(path.data(), flag)); }
-        inline std::string sha3_256(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::sha3_256(Util::LoadFile(path,        flag)); }
-        inline std::string sha3_256(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha3_256(Util::LoadFile(path.data(), flag)); }
-        inline std::string sha3_384(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::sha3_384(Util::LoadFile(path,        flag)); }
-        inline std::string sha3_384(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha3_384(Util::LoadFile(path.data(), flag)); }
-        inline std::string sha3_512(const char* path,      std::ios::openmode flag = std::ios::binary) { return Hash::sha3_512(Util::LoadFile(path,        flag)); }
-        inline std::string sha3_512(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Hash::sha3_512(Util::LoadFile(path.data(), flag)); }
+        inline std::string sha3_224(const char* path,      std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(224), path,        flag); }
+        inline std::string sha3_224(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(224), path.data(), flag); }
+        inline std::string sha3_256(const char* path,      std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(256), path,        flag); }
+        inline std::string sha3_256(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(256), path.data(), flag); }
+        inline std::string sha3_384(const char* path,      std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(384), path,        flag); }
+        inline std::string sha3_384(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(384), path.data(), flag); }
+        inline std::string sha3_512(const char* path,      std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(512), path,        flag); }
+        inline std::string sha3_512(std::string_view path, std::ios::openmode flag = std::ios::binary) { return Util::HashFile(Sha3(512), path.data(), flag); }
     }
 }
 #endif // HASH_ENABLE_KECCAK
@@ -2787,54 +4360,80 @@ namespace Hash
 #if HASH_ENABLE_C_INTERFACE == 1
 HASH_INLINE void hash_private_keccak_Keccak(unsigned int rate, unsigned int capacity, const unsigned char* input, unsigned long long int inputByteLen, unsigned char delimitedSuffix, unsigned char* output, unsigned long long int outputByteLen);
 
-// heap allocated if outsizeBytes > HASH_SHAKE_128_MALLOC_LIMIT
-HASH_INLINE const char* hash_shake128_binary(const char* data, size_t size, size_t outsizeBytes, char* buffer /*outsizeBytes+1*/)
+typedef Hash_Private_Keccak Hash_Shake[1];
+
+HASH_INLINE void hash_shake128_init(Hash_Shake s) { hash_private_keccak_init(s, 1344, 0x1F); }
+HASH_INLINE void hash_shake256_init(Hash_Shake s) { hash_private_keccak_init(s, 1088, 0x1F); }
+
+HASH_INLINE void hash_shake_update_binary(Hash_Shake s, const char* data, size_t size)
 {
-    static char hex[HASH_SHAKE_128_MALLOC_LIMIT + 1];
-    static unsigned char intBuff[HASH_SHAKE_128_MALLOC_LIMIT / 2];
-    char* out = buffer;
-    unsigned char* buff = intBuff;
+    hash_private_keccak_absorb(s, (const unsigned char*)data, size);
+}
 
-    if (buffer == NULL)
+HASH_INLINE void hash_shake_update(Hash_Shake s, const char* data)
+{
+    hash_shake_update_binary(s, data, strlen(data));
+}
+
+// optional, the first squeeze finalizes, no more updates afterwards
+HASH_INLINE void hash_shake_finalize(Hash_Shake s)
+{
+    hash_private_keccak_finalize(s);
+}
+
+// the next size bytes of output, call it again for more
+HASH_INLINE void hash_shake_squeeze(Hash_Shake s, unsigned char* out, size_t size)
+{
+    hash_private_keccak_squeeze(s, out, size);
+}
+
+// the next outsizeBytes / 2 bytes of output as hex, buffer size must be at least outsizeBytes + 1
+HASH_INLINE const char* hash_shake_hexsqueeze(Hash_Shake s, size_t outsizeBytes, char* buffer)
+{
+    unsigned char buff[32];
+    size_t k = 0;
+    for (size_t remaining = outsizeBytes / 2; remaining > 0;)
     {
-        if (outsizeBytes > HASH_SHAKE_128_MALLOC_LIMIT)
-        {
-            char* tmp = (char*)malloc(outsizeBytes * 3 + 1);
-            buff = (unsigned char*)tmp;
-            out = &tmp[outsizeBytes];
-        }
-        else
-            out = hex;
+        const size_t n = remaining < sizeof(buff) ? remaining : sizeof(buff);
+        hash_private_keccak_squeeze(s, buff, n);
+        hash_util_char_array_to_hex_string(buff, n, &buffer[k]);
+        k += 2 * n;
+        remaining -= n;
     }
-
-    hash_private_keccak_Keccak(1344, 256, (const unsigned char*)data, size, 0x1F, buff, outsizeBytes / 2);
-    hash_util_char_array_to_hex_string(buff, outsizeBytes / 2, out);
-    return out;
+    buffer[k] = 0;
+    return buffer;
 }
 
-// heap allocated if outsizeBytes > HASH_SHAKE_256_MALLOC_LIMIT
-HASH_INLINE const char* hash_shake256_binary(const char* data, size_t size, size_t outsizeBytes, char* buffer /*outsizeBytes+1*/)
+// heap allocated if buffer == NULL and outsizeBytes > limit
+HASH_INLINE const char* hash_private_shake_hexdigest(Hash_Shake s, size_t outsizeBytes, char* buffer, char* hex, size_t limit)
 {
-    static char hex[HASH_SHAKE_256_MALLOC_LIMIT + 1];
-    static unsigned char intBuff[HASH_SHAKE_256_MALLOC_LIMIT / 2];
     char* out = buffer;
-    unsigned char* buff = intBuff;
-
     if (buffer == NULL)
     {
-        if (outsizeBytes > HASH_SHAKE_256_MALLOC_LIMIT)
-        {
-            char* tmp = (char*)malloc(outsizeBytes * 3 + 1);
-            buff = (unsigned char*)tmp;
-            out = &tmp[outsizeBytes];
-        }
-        else
-            out = hex;
+        out = outsizeBytes > limit ? (char*)malloc(outsizeBytes + 1) : hex;
+        if (out == NULL) return "";
     }
+    return hash_shake_hexsqueeze(s, outsizeBytes, out);
+}
 
-    hash_private_keccak_Keccak(1088, 512, (const unsigned char*)data, size, 0x1F, buff, outsizeBytes / 2);
-    hash_util_char_array_to_hex_string(buff, outsizeBytes / 2, out);
-    return out;
+// heap allocated if outsizeBytes > HASH_SHAKE_128_MALLOC_LIMIT
+HASH_INLINE const char* hash_shake128_binary(const char* data, size_t size, size_t outsizeBytes, char* buffer /*outsizeBytes+1*/)
+{
+    HASH_INTERNAL_BUFFER char hex[HASH_SHAKE_128_MALLOC_LIMIT + 1];
+    Hash_Shake s;
+    hash_shake128_init(s);
+    hash_shake_update_binary(s, data, size);
+    return hash_private_shake_hexdigest(s, outsizeBytes, buffer, hex, HASH_SHAKE_128_MALLOC_LIMIT);
+}
+
+// heap allocated if outsizeBytes > HASH_SHAKE_256_MALLOC_LIMIT
+HASH_INLINE const char* hash_shake256_binary(const char* data, size_t size, size_t outsizeBytes, char* buffer /*outsizeBytes+1*/)
+{
+    HASH_INTERNAL_BUFFER char hex[HASH_SHAKE_256_MALLOC_LIMIT + 1];
+    Hash_Shake s;
+    hash_shake256_init(s);
+    hash_shake_update_binary(s, data, size);
+    return hash_private_shake_hexdigest(s, outsizeBytes, buffer, hex, HASH_SHAKE_256_MALLOC_LIMIT);
 }
 
 HASH_INLINE const char* hash_shake128(const char* data, size_t outsizeBytes, char* buffer) { return hash_shake128_binary(data, strlen(data), outsizeBytes, buffer); }
@@ -2843,26 +4442,27 @@ HASH_INLINE const char* hash_shake256(const char* data, size_t outsizeBytes, cha
 HASH_INLINE const char* hash_shake128_easy(const char* data, size_t outsizeBytes) { return hash_shake128_binary(data, strlen(data), outsizeBytes, NULL); }
 HASH_INLINE const char* hash_shake256_easy(const char* data, size_t outsizeBytes) { return hash_shake256_binary(data, strlen(data), outsizeBytes, NULL); }
 
+HASH_INLINE void hash_private_shake_file_update(void* s, const char* data, size_t size)
+{
+    hash_shake_update_binary((Hash_Private_Keccak*)s, data, size);
+}
+
 HASH_INLINE const char* hash_shake128_file(const char* path, const char* mode, size_t outsizeBytes, char* buffer)
 {
-    long fsize;
-    char* content = hash_util_load_file(path, mode, &fsize);
-    if (content == NULL) return "";
-    const char* hash = hash_shake128_binary(content, fsize, outsizeBytes, buffer);
-    if (content != NULL)
-        free(content);
-    return hash;
+    HASH_INTERNAL_BUFFER char hex[HASH_SHAKE_128_MALLOC_LIMIT + 1];
+    Hash_Shake s;
+    hash_shake128_init(s);
+    if (!hash_util_read_file(path, mode, hash_private_shake_file_update, s)) return "";
+    return hash_private_shake_hexdigest(s, outsizeBytes, buffer, hex, HASH_SHAKE_128_MALLOC_LIMIT);
 }
 
 HASH_INLINE const char* hash_shake256_file(const char* path, const char* mode, size_t outsizeBytes, char* buffer)
 {
-    long fsize;
-    char* content = hash_util_load_file(path, mode, &fsize);
-    if (content == NULL) return "";
-    const char* hash = hash_shake256_binary(content, fsize, outsizeBytes, buffer);
-    if (content != NULL)
-        free(content);
-    return hash;
+    HASH_INTERNAL_BUFFER char hex[HASH_SHAKE_256_MALLOC_LIMIT + 1];
+    Hash_Shake s;
+    hash_shake256_init(s);
+    if (!hash_util_read_file(path, mode, hash_private_shake_file_update, s)) return "";
+    return hash_private_shake_hexdigest(s, outsizeBytes, buffer, hex, HASH_SHAKE_256_MALLOC_LIMIT);
 }
 
 HASH_INLINE const char* hash_shake128_file_easy(const char* path, const char* mode, size_t outsizeBytes) { return hash_shake128_file(path, mode, outsizeBytes, NULL); }
@@ -2871,10 +4471,63 @@ HASH_INLINE const char* hash_shake256_file_easy(const char* path, const char* mo
 
 
 
+typedef Hash_Private_Keccak Hash_Sha3[1];
+
+HASH_INLINE void hash_sha3_224_init(Hash_Sha3 s) { hash_private_keccak_init(s, 1152, 0x06); }
+HASH_INLINE void hash_sha3_256_init(Hash_Sha3 s) { hash_private_keccak_init(s, 1088, 0x06); }
+HASH_INLINE void hash_sha3_384_init(Hash_Sha3 s) { hash_private_keccak_init(s,  832, 0x06); }
+HASH_INLINE void hash_sha3_512_init(Hash_Sha3 s) { hash_private_keccak_init(s,  576, 0x06); }
+
+HASH_INLINE void hash_sha3_update_binary(Hash_Sha3 s, const char* data, size_t size)
+{
+    hash_private_keccak_absorb(s, (const unsigned char*)data, size);
+}
+
+HASH_INLINE void hash_sha3_update(Hash_Sha3 s, const char* data)
+{
+    hash_sha3_update_binary(s, data, strlen(data));
+}
+
+HASH_INLINE void hash_sha3_finalize(Hash_Sha3 s)
+{
+    hash_private_keccak_finalize(s);
+}
+
+// the raw digest, out must hold the digest size in bytes (64 for sha3-512)
+HASH_INLINE void hash_sha3_digest(const Hash_Sha3 s, uint8_t* out)
+{
+    // the digest is half the capacity and fits in the first block of output
+    memcpy(out, s->state, (200 - s->rateInBytes) / 2);
+}
+
+// if buffer == NULL returns internal buffer, buffer size must be at least 2 * digest size + 1 (129 for sha3-512)
+HASH_INLINE const char* hash_sha3_hexdigest(const Hash_Sha3 s, char* buffer)
+{
+    HASH_INTERNAL_BUFFER char hex[129];
+    char* out = buffer == NULL ? hex : buffer;
+    // the digest is half the capacity and fits in the first block of output
+    hash_util_char_array_to_hex_string((const unsigned char*)s->state, (200 - s->rateInBytes) / 2, out);
+    return out;
+}
+
+HASH_INLINE void hash_private_sha3_file_update(void* s, const char* data, size_t size)
+{
+    hash_sha3_update_binary((Hash_Private_Keccak*)s, data, size);
+}
+
+HASH_INLINE const char* hash_private_sha3_file(void (*init)(Hash_Sha3), const char* path, const char* mode, char* buffer)
+{
+    Hash_Sha3 s;
+    init(s);
+    if (!hash_util_read_file(path, mode, hash_private_sha3_file_update, s)) return "";
+    hash_sha3_finalize(s);
+    return hash_sha3_hexdigest(s, buffer);
+}
+
 HASH_INLINE const char* hash_sha3_224_binary(const char* data, size_t size, char* buffer /*57 chars*/)
 {
-    static char hex[57];
-    static unsigned char buff[28];
+    HASH_INTERNAL_BUFFER char hex[57];
+    unsigned char buff[28];
     char* out = buffer == NULL ? hex : buffer;
     hash_private_keccak_Keccak(1152, 448, (const unsigned char*)data, size, 0x06, buff, 28);
     hash_util_char_array_to_hex_string(buff, 28, out);
@@ -2883,8 +4536,8 @@ HASH_INLINE const char* hash_sha3_224_binary(const char* data, size_t size, char
 
 HASH_INLINE const char* hash_sha3_256_binary(const char* data, size_t size, char* buffer /*65 chars*/)
 {
-    static char hex[65];
-    static unsigned char buff[32];
+    HASH_INTERNAL_BUFFER char hex[65];
+    unsigned char buff[32];
     char* out = buffer == NULL ? hex : buffer;
     hash_private_keccak_Keccak(1088, 512, (const unsigned char*)data, size, 0x06, buff, 32);
     hash_util_char_array_to_hex_string(buff, 32, out);
@@ -2893,8 +4546,8 @@ HASH_INLINE const char* hash_sha3_256_binary(const char* data, size_t size, char
 
 HASH_INLINE const char* hash_sha3_384_binary(const char* data, size_t size, char* buffer /*97 chars*/)
 {
-    static char hex[97];
-    static unsigned char buff[48];
+    HASH_INTERNAL_BUFFER char hex[97];
+    unsigned char buff[48];
     char* out = buffer == NULL ? hex : buffer;
     hash_private_keccak_Keccak(832, 768, (const unsigned char*)data, size, 0x06, buff, 48);
     hash_util_char_array_to_hex_string(buff, 48, out);
@@ -2903,8 +4556,8 @@ HASH_INLINE const char* hash_sha3_384_binary(const char* data, size_t size, char
 
 HASH_INLINE const char* hash_sha3_512_binary(const char* data, size_t size, char* buffer /*129 chars*/)
 {
-    static char hex[129];
-    static unsigned char buff[64];
+    HASH_INTERNAL_BUFFER char hex[129];
+    unsigned char buff[64];
     char* out = buffer == NULL ? hex : buffer;
     hash_private_keccak_Keccak(576, 1024, (const unsigned char*)data, size, 0x06, buff, 64);
     hash_util_char_array_to_hex_string(buff, 64, out);
@@ -2921,15 +4574,15 @@ HASH_INLINE const char* hash_sha3_256_easy(const char* data) { return hash_sha3_
 HASH_INLINE const char* hash_sha3_384_easy(const char* data) { return hash_sha3_384_binary(data, strlen(data), NULL); }
 HASH_INLINE const char* hash_sha3_512_easy(const char* data) { return hash_sha3_512_binary(data, strlen(data), NULL); }
 
-HASH_INLINE const char* hash_sha3_224_file(const char* path, const char* mode, char* buffer) { return hash_util_hash_file(path, mode, hash_sha3_224_binary, buffer); }
-HASH_INLINE const char* hash_sha3_256_file(const char* path, const char* mode, char* buffer) { return hash_util_hash_file(path, mode, hash_sha3_256_binary, buffer); }
-HASH_INLINE const char* hash_sha3_384_file(const char* path, const char* mode, char* buffer) { return hash_util_hash_file(path, mode, hash_sha3_384_binary, buffer); }
-HASH_INLINE const char* hash_sha3_512_file(const char* path, const char* mode, char* buffer) { return hash_util_hash_file(path, mode, hash_sha3_512_binary, buffer); }
+HASH_INLINE const char* hash_sha3_224_file(const char* path, const char* mode, char* buffer) { return hash_private_sha3_file(hash_sha3_224_init, path, mode, buffer); }
+HASH_INLINE const char* hash_sha3_256_file(const char* path, const char* mode, char* buffer) { return hash_private_sha3_file(hash_sha3_256_init, path, mode, buffer); }
+HASH_INLINE const char* hash_sha3_384_file(const char* path, const char* mode, char* buffer) { return hash_private_sha3_file(hash_sha3_384_init, path, mode, buffer); }
+HASH_INLINE const char* hash_sha3_512_file(const char* path, const char* mode, char* buffer) { return hash_private_sha3_file(hash_sha3_512_init, path, mode, buffer); }
 
-HASH_INLINE const char* hash_sha3_224_file_easy(const char* path, const char* mode) { return hash_util_hash_file(path, mode, hash_sha3_224_binary, NULL); }
-HASH_INLINE const char* hash_sha3_256_file_easy(const char* path, const char* mode) { return hash_util_hash_file(path, mode, hash_sha3_256_binary, NULL); }
-HASH_INLINE const char* hash_sha3_384_file_easy(const char* path, const char* mode) { return hash_util_hash_file(path, mode, hash_sha3_384_binary, NULL); }
-HASH_INLINE const char* hash_sha3_512_file_easy(const char* path, const char* mode) { return hash_util_hash_file(path, mode, hash_sha3_512_binary, NULL); }
+HASH_INLINE const char* hash_sha3_224_file_easy(const char* path, const char* mode) { return hash_private_sha3_file(hash_sha3_224_init, path, mode, NULL); }
+HASH_INLINE const char* hash_sha3_256_file_easy(const char* path, const char* mode) { return hash_private_sha3_file(hash_sha3_256_init, path, mode, NULL); }
+HASH_INLINE const char* hash_sha3_384_file_easy(const char* path, const char* mode) { return hash_private_sha3_file(hash_sha3_384_init, path, mode, NULL); }
+HASH_INLINE const char* hash_sha3_512_file_easy(const char* path, const char* mode) { return hash_private_sha3_file(hash_sha3_512_init, path, mode, NULL); }
 #endif // HASH_ENABLE_C_INTERFACE
 
 /*
@@ -2996,6 +4649,331 @@ HASH_INLINE void hash_private_keccak_xor64(uint8_t* x, uint64_t u)
 #define hash_private_keccak_XORLANE(x, y, lane)     hash_private_keccak_xor64((uint8_t*)state+sizeof(uint64_t)*HASH_PRIVATE_KECCAK_I(x, y), lane)
 #endif
 
+#if HASH_KECCAK_UNROLLED == 1 && UINTPTR_MAX > 0xFFFFFFFFu
+/**
+  * Keccak-f[1600] with the 25 lanes in local variables and the steps unrolled
+  * lane by lane, lanes are named A[y][x] with x = a, e, i, o, u and y = b, g, k, m, s.
+  */
+static const uint64_t hash_private_keccak_round_constants[24] =
+{
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+HASH_INLINE void hash_private_keccak_KeccakF1600_StatePermute(void* state)
+{
+    uint64_t Aba, Abe, Abi, Abo, Abu, Aga, Age, Agi, Ago, Agu, Aka, Ake, Aki, Ako, Aku, Ama, Ame, Ami, Amo, Amu, Asa, Ase, Asi, Aso, Asu;
+    uint64_t Bba, Bbe, Bbi, Bbo, Bbu, Bga, Bge, Bgi, Bgo, Bgu, Bka, Bke, Bki, Bko, Bku, Bma, Bme, Bmi, Bmo, Bmu, Bsa, Bse, Bsi, Bso, Bsu;
+    uint64_t Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du;
+    unsigned int round;
+
+    Aba = HASH_PRIVATE_KECCAK_READLANE(0, 0); Abe = HASH_PRIVATE_KECCAK_READLANE(1, 0); Abi = HASH_PRIVATE_KECCAK_READLANE(2, 0); Abo = HASH_PRIVATE_KECCAK_READLANE(3, 0); Abu = HASH_PRIVATE_KECCAK_READLANE(4, 0);
+    Aga = HASH_PRIVATE_KECCAK_READLANE(0, 1); Age = HASH_PRIVATE_KECCAK_READLANE(1, 1); Agi = HASH_PRIVATE_KECCAK_READLANE(2, 1); Ago = HASH_PRIVATE_KECCAK_READLANE(3, 1); Agu = HASH_PRIVATE_KECCAK_READLANE(4, 1);
+    Aka = HASH_PRIVATE_KECCAK_READLANE(0, 2); Ake = HASH_PRIVATE_KECCAK_READLANE(1, 2); Aki = HASH_PRIVATE_KECCAK_READLANE(2, 2); Ako = HASH_PRIVATE_KECCAK_READLANE(3, 2); Aku = HASH_PRIVATE_KECCAK_READLANE(4, 2);
+    Ama = HASH_PRIVATE_KECCAK_READLANE(0, 3); Ame = HASH_PRIVATE_KECCAK_READLANE(1, 3); Ami = HASH_PRIVATE_KECCAK_READLANE(2, 3); Amo = HASH_PRIVATE_KECCAK_READLANE(3, 3); Amu = HASH_PRIVATE_KECCAK_READLANE(4, 3);
+    Asa = HASH_PRIVATE_KECCAK_READLANE(0, 4); Ase = HASH_PRIVATE_KECCAK_READLANE(1, 4); Asi = HASH_PRIVATE_KECCAK_READLANE(2, 4); Aso = HASH_PRIVATE_KECCAK_READLANE(3, 4); Asu = HASH_PRIVATE_KECCAK_READLANE(4, 4);
+
+    for (round = 0; round < 24; round++) {
+        /* θ */
+        Ca = Aba ^ Aga ^ Aka ^ Ama ^ Asa;
+        Ce = Abe ^ Age ^ Ake ^ Ame ^ Ase;
+        Ci = Abi ^ Agi ^ Aki ^ Ami ^ Asi;
+        Co = Abo ^ Ago ^ Ako ^ Amo ^ Aso;
+        Cu = Abu ^ Agu ^ Aku ^ Amu ^ Asu;
+        Da = Cu ^ HASH_PRIVATE_KECCAK_ROL64(Ce, 1);
+        De = Ca ^ HASH_PRIVATE_KECCAK_ROL64(Ci, 1);
+        Di = Ce ^ HASH_PRIVATE_KECCAK_ROL64(Co, 1);
+        Do = Ci ^ HASH_PRIVATE_KECCAK_ROL64(Cu, 1);
+        Du = Co ^ HASH_PRIVATE_KECCAK_ROL64(Ca, 1);
+
+        /* ρ and π */
+        Bba = Aba ^ Da;
+        Bka = HASH_PRIVATE_KECCAK_ROL64((Abe ^ De), 1);
+        Bsa = HASH_PRIVATE_KECCAK_ROL64((Abi ^ Di), 62);
+        Bga = HASH_PRIVATE_KECCAK_ROL64((Abo ^ Do), 28);
+        Bma = HASH_PRIVATE_KECCAK_ROL64((Abu ^ Du), 27);
+        Bme = HASH_PRIVATE_KECCAK_ROL64((Aga ^ Da), 36);
+        Bbe = HASH_PRIVATE_KECCAK_ROL64((Age ^ De), 44);
+        Bke = HASH_PRIVATE_KECCAK_ROL64((Agi ^ Di), 6);
+        Bse = HASH_PRIVATE_KECCAK_ROL64((Ago ^ Do), 55);
+        Bge = HASH_PRIVATE_KECCAK_ROL64((Agu ^ Du), 20);
+        Bgi = HASH_PRIVATE_KECCAK_ROL64((Aka ^ Da), 3);
+        Bmi = HASH_PRIVATE_KECCAK_ROL64((Ake ^ De), 10);
+        Bbi = HASH_PRIVATE_KECCAK_ROL64((Aki ^ Di), 43);
+        Bki = HASH_PRIVATE_KECCAK_ROL64((Ako ^ Do), 25);
+        Bsi = HASH_PRIVATE_KECCAK_ROL64((Aku ^ Du), 39);
+        Bso = HASH_PRIVATE_KECCAK_ROL64((Ama ^ Da), 41);
+        Bgo = HASH_PRIVATE_KECCAK_ROL64((Ame ^ De), 45);
+        Bmo = HASH_PRIVATE_KECCAK_ROL64((Ami ^ Di), 15);
+        Bbo = HASH_PRIVATE_KECCAK_ROL64((Amo ^ Do), 21);
+        Bko = HASH_PRIVATE_KECCAK_ROL64((Amu ^ Du), 8);
+        Bku = HASH_PRIVATE_KECCAK_ROL64((Asa ^ Da), 18);
+        Bsu = HASH_PRIVATE_KECCAK_ROL64((Ase ^ De), 2);
+        Bgu = HASH_PRIVATE_KECCAK_ROL64((Asi ^ Di), 61);
+        Bmu = HASH_PRIVATE_KECCAK_ROL64((Aso ^ Do), 56);
+        Bbu = HASH_PRIVATE_KECCAK_ROL64((Asu ^ Du), 14);
+
+        /* χ and ι */
+        Aba = Bba ^ (~Bbe & Bbi);
+        Abe = Bbe ^ (~Bbi & Bbo);
+        Abi = Bbi ^ (~Bbo & Bbu);
+        Abo = Bbo ^ (~Bbu & Bba);
+        Abu = Bbu ^ (~Bba & Bbe);
+        Aga = Bga ^ (~Bge & Bgi);
+        Age = Bge ^ (~Bgi & Bgo);
+        Agi = Bgi ^ (~Bgo & Bgu);
+        Ago = Bgo ^ (~Bgu & Bga);
+        Agu = Bgu ^ (~Bga & Bge);
+        Aka = Bka ^ (~Bke & Bki);
+        Ake = Bke ^ (~Bki & Bko);
+        Aki = Bki ^ (~Bko & Bku);
+        Ako = Bko ^ (~Bku & Bka);
+        Aku = Bku ^ (~Bka & Bke);
+        Ama = Bma ^ (~Bme & Bmi);
+        Ame = Bme ^ (~Bmi & Bmo);
+        Ami = Bmi ^ (~Bmo & Bmu);
+        Amo = Bmo ^ (~Bmu & Bma);
+        Amu = Bmu ^ (~Bma & Bme);
+        Asa = Bsa ^ (~Bse & Bsi);
+        Ase = Bse ^ (~Bsi & Bso);
+        Asi = Bsi ^ (~Bso & Bsu);
+        Aso = Bso ^ (~Bsu & Bsa);
+        Asu = Bsu ^ (~Bsa & Bse);
+        Aba ^= hash_private_keccak_round_constants[round];
+    }
+
+    hash_private_keccak_WRITELANE(0, 0, Aba); hash_private_keccak_WRITELANE(1, 0, Abe); hash_private_keccak_WRITELANE(2, 0, Abi); hash_private_keccak_WRITELANE(3, 0, Abo); hash_private_keccak_WRITELANE(4, 0, Abu);
+    hash_private_keccak_WRITELANE(0, 1, Aga); hash_private_keccak_WRITELANE(1, 1, Age); hash_private_keccak_WRITELANE(2, 1, Agi); hash_private_keccak_WRITELANE(3, 1, Ago); hash_private_keccak_WRITELANE(4, 1, Agu);
+    hash_private_keccak_WRITELANE(0, 2, Aka); hash_private_keccak_WRITELANE(1, 2, Ake); hash_private_keccak_WRITELANE(2, 2, Aki); hash_private_keccak_WRITELANE(3, 2, Ako); hash_private_keccak_WRITELANE(4, 2, Aku);
+    hash_private_keccak_WRITELANE(0, 3, Ama); hash_private_keccak_WRITELANE(1, 3, Ame); hash_private_keccak_WRITELANE(2, 3, Ami); hash_private_keccak_WRITELANE(3, 3, Amo); hash_private_keccak_WRITELANE(4, 3, Amu);
+    hash_private_keccak_WRITELANE(0, 4, Asa); hash_private_keccak_WRITELANE(1, 4, Ase); hash_private_keccak_WRITELANE(2, 4, Asi); hash_private_keccak_WRITELANE(3, 4, Aso); hash_private_keccak_WRITELANE(4, 4, Asu);
+}
+#elif HASH_KECCAK_UNROLLED == 1
+/**
+  * Keccak-f[1600] for 32 bit cpus (e.g. the esp32) with bit interleaved lanes:
+  * every lane is split into a word of its even bits (0) and one of its odd bits (1),
+  * so a 64 bit rotation becomes two 32 bit rotations. The steps are unrolled like the 64 bit version.
+  */
+#define HASH_PRIVATE_KECCAK_ROL32(a, offset) ((((uint32_t)a) << offset) ^ (((uint32_t)a) >> (32-offset)))
+
+/* Gathers the even bits of x in the low and the odd bits in the high half, every step swaps bit groups */
+HASH_INLINE uint32_t hash_private_keccak_unshuffle(uint32_t x)
+{
+    uint32_t t;
+    t = (x ^ (x >> 1)) & 0x22222222UL; x = x ^ t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0CUL; x = x ^ t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00F000F0UL; x = x ^ t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000FF00UL; x = x ^ t ^ (t << 8);
+    return x;
+}
+
+/* Inverse of hash_private_keccak_unshuffle, the same swaps in reverse order */
+HASH_INLINE uint32_t hash_private_keccak_shuffle(uint32_t x)
+{
+    uint32_t t;
+    t = (x ^ (x >> 8)) & 0x0000FF00UL; x = x ^ t ^ (t << 8);
+    t = (x ^ (x >> 4)) & 0x00F000F0UL; x = x ^ t ^ (t << 4);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0CUL; x = x ^ t ^ (t << 2);
+    t = (x ^ (x >> 1)) & 0x22222222UL; x = x ^ t ^ (t << 1);
+    return x;
+}
+
+HASH_INLINE void hash_private_keccak_interleave(uint64_t lane, uint32_t* even, uint32_t* odd)
+{
+    const uint32_t low = hash_private_keccak_unshuffle((uint32_t)lane);
+    const uint32_t high = hash_private_keccak_unshuffle((uint32_t)(lane >> 32));
+    *even = (low & 0x0000FFFFUL) | (high << 16);
+    *odd = (low >> 16) | (high & 0xFFFF0000UL);
+}
+
+HASH_INLINE uint64_t hash_private_keccak_deinterleave(uint32_t even, uint32_t odd)
+{
+    const uint32_t low = hash_private_keccak_shuffle((even & 0x0000FFFFUL) | (odd << 16));
+    const uint32_t high = hash_private_keccak_shuffle((even >> 16) | (odd & 0xFFFF0000UL));
+    return ((uint64_t)high << 32) | low;
+}
+
+/* The round constants split into their even and odd bits */
+static const uint32_t hash_private_keccak_round_constants_interleaved[24][2] =
+{
+    { 0x00000001, 0x00000000 }, { 0x00000000, 0x00000089 }, { 0x00000000, 0x8000008b }, { 0x00000000, 0x80008080 },
+    { 0x00000001, 0x0000008b }, { 0x00000001, 0x00008000 }, { 0x00000001, 0x80008088 }, { 0x00000001, 0x80000082 },
+    { 0x00000000, 0x0000000b }, { 0x00000000, 0x0000000a }, { 0x00000001, 0x00008082 }, { 0x00000000, 0x00008003 },
+    { 0x00000001, 0x0000808b }, { 0x00000001, 0x8000000b }, { 0x00000001, 0x8000008a }, { 0x00000001, 0x80000081 },
+    { 0x00000000, 0x80000081 }, { 0x00000000, 0x80000008 }, { 0x00000000, 0x00000083 }, { 0x00000000, 0x80008003 },
+    { 0x00000001, 0x80008088 }, { 0x00000000, 0x80000088 }, { 0x00000001, 0x00008000 }, { 0x00000000, 0x80008082 }
+};
+
+HASH_INLINE void hash_private_keccak_KeccakF1600_StatePermute(void* state)
+{
+    uint32_t Aba0, Aba1, Abe0, Abe1, Abi0, Abi1, Abo0, Abo1, Abu0, Abu1, Aga0, Aga1, Age0, Age1, Agi0, Agi1, Ago0, Ago1, Agu0, Agu1, Aka0, Aka1, Ake0, Ake1, Aki0, Aki1, Ako0, Ako1, Aku0, Aku1, Ama0, Ama1, Ame0, Ame1, Ami0, Ami1, Amo0, Amo1, Amu0, Amu1, Asa0, Asa1, Ase0, Ase1, Asi0, Asi1, Aso0, Aso1, Asu0, Asu1;
+    uint32_t Bba0, Bba1, Bbe0, Bbe1, Bbi0, Bbi1, Bbo0, Bbo1, Bbu0, Bbu1, Bga0, Bga1, Bge0, Bge1, Bgi0, Bgi1, Bgo0, Bgo1, Bgu0, Bgu1, Bka0, Bka1, Bke0, Bke1, Bki0, Bki1, Bko0, Bko1, Bku0, Bku1, Bma0, Bma1, Bme0, Bme1, Bmi0, Bmi1, Bmo0, Bmo1, Bmu0, Bmu1, Bsa0, Bsa1, Bse0, Bse1, Bsi0, Bsi1, Bso0, Bso1, Bsu0, Bsu1;
+    uint32_t Ca0, Ca1, Ce0, Ce1, Ci0, Ci1, Co0, Co1, Cu0, Cu1, Da0, Da1, De0, De1, Di0, Di1, Do0, Do1, Du0, Du1;
+    unsigned int round;
+
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(0, 0), &Aba0, &Aba1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(1, 0), &Abe0, &Abe1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(2, 0), &Abi0, &Abi1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(3, 0), &Abo0, &Abo1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(4, 0), &Abu0, &Abu1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(0, 1), &Aga0, &Aga1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(1, 1), &Age0, &Age1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(2, 1), &Agi0, &Agi1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(3, 1), &Ago0, &Ago1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(4, 1), &Agu0, &Agu1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(0, 2), &Aka0, &Aka1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(1, 2), &Ake0, &Ake1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(2, 2), &Aki0, &Aki1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(3, 2), &Ako0, &Ako1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(4, 2), &Aku0, &Aku1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(0, 3), &Ama0, &Ama1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(1, 3), &Ame0, &Ame1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(2, 3), &Ami0, &Ami1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(3, 3), &Amo0, &Amo1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(4, 3), &Amu0, &Amu1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(0, 4), &Asa0, &Asa1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(1, 4), &Ase0, &Ase1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(2, 4), &Asi0, &Asi1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(3, 4), &Aso0, &Aso1);
+    hash_private_keccak_interleave(HASH_PRIVATE_KECCAK_READLANE(4, 4), &Asu0, &Asu1);
+
+    for (round = 0; round < 24; round++) {
+        /* θ */
+        Ca0 = Aba0 ^ Aga0 ^ Aka0 ^ Ama0 ^ Asa0;
+        Ca1 = Aba1 ^ Aga1 ^ Aka1 ^ Ama1 ^ Asa1;
+        Ce0 = Abe0 ^ Age0 ^ Ake0 ^ Ame0 ^ Ase0;
+        Ce1 = Abe1 ^ Age1 ^ Ake1 ^ Ame1 ^ Ase1;
+        Ci0 = Abi0 ^ Agi0 ^ Aki0 ^ Ami0 ^ Asi0;
+        Ci1 = Abi1 ^ Agi1 ^ Aki1 ^ Ami1 ^ Asi1;
+        Co0 = Abo0 ^ Ago0 ^ Ako0 ^ Amo0 ^ Aso0;
+        Co1 = Abo1 ^ Ago1 ^ Ako1 ^ Amo1 ^ Aso1;
+        Cu0 = Abu0 ^ Agu0 ^ Aku0 ^ Amu0 ^ Asu0;
+        Cu1 = Abu1 ^ Agu1 ^ Aku1 ^ Amu1 ^ Asu1;
+        Da0 = Cu0 ^ HASH_PRIVATE_KECCAK_ROL32(Ce1, 1);
+        Da1 = Cu1 ^ Ce0;
+        De0 = Ca0 ^ HASH_PRIVATE_KECCAK_ROL32(Ci1, 1);
+        De1 = Ca1 ^ Ci0;
+        Di0 = Ce0 ^ HASH_PRIVATE_KECCAK_ROL32(Co1, 1);
+        Di1 = Ce1 ^ Co0;
+        Do0 = Ci0 ^ HASH_PRIVATE_KECCAK_ROL32(Cu1, 1);
+        Do1 = Ci1 ^ Cu0;
+        Du0 = Co0 ^ HASH_PRIVATE_KECCAK_ROL32(Ca1, 1);
+        Du1 = Co1 ^ Ca0;
+
+        /* ρ and π, a 64 bit rotation is a rotation of both halves, odd amounts swap them */
+        Bba0 = Aba0 ^ Da0; Bba1 = Aba1 ^ Da1;
+        Bka0 = HASH_PRIVATE_KECCAK_ROL32((Abe1 ^ De1), 1); Bka1 = Abe0 ^ De0;
+        Bsa0 = HASH_PRIVATE_KECCAK_ROL32((Abi0 ^ Di0), 31); Bsa1 = HASH_PRIVATE_KECCAK_ROL32((Abi1 ^ Di1), 31);
+        Bga0 = HASH_PRIVATE_KECCAK_ROL32((Abo0 ^ Do0), 14); Bga1 = HASH_PRIVATE_KECCAK_ROL32((Abo1 ^ Do1), 14);
+        Bma0 = HASH_PRIVATE_KECCAK_ROL32((Abu1 ^ Du1), 14); Bma1 = HASH_PRIVATE_KECCAK_ROL32((Abu0 ^ Du0), 13);
+        Bme0 = HASH_PRIVATE_KECCAK_ROL32((Aga0 ^ Da0), 18); Bme1 = HASH_PRIVATE_KECCAK_ROL32((Aga1 ^ Da1), 18);
+        Bbe0 = HASH_PRIVATE_KECCAK_ROL32((Age0 ^ De0), 22); Bbe1 = HASH_PRIVATE_KECCAK_ROL32((Age1 ^ De1), 22);
+        Bke0 = HASH_PRIVATE_KECCAK_ROL32((Agi0 ^ Di0), 3); Bke1 = HASH_PRIVATE_KECCAK_ROL32((Agi1 ^ Di1), 3);
+        Bse0 = HASH_PRIVATE_KECCAK_ROL32((Ago1 ^ Do1), 28); Bse1 = HASH_PRIVATE_KECCAK_ROL32((Ago0 ^ Do0), 27);
+        Bge0 = HASH_PRIVATE_KECCAK_ROL32((Agu0 ^ Du0), 10); Bge1 = HASH_PRIVATE_KECCAK_ROL32((Agu1 ^ Du1), 10);
+        Bgi0 = HASH_PRIVATE_KECCAK_ROL32((Aka1 ^ Da1), 2); Bgi1 = HASH_PRIVATE_KECCAK_ROL32((Aka0 ^ Da0), 1);
+        Bmi0 = HASH_PRIVATE_KECCAK_ROL32((Ake0 ^ De0), 5); Bmi1 = HASH_PRIVATE_KECCAK_ROL32((Ake1 ^ De1), 5);
+        Bbi0 = HASH_PRIVATE_KECCAK_ROL32((Aki1 ^ Di1), 22); Bbi1 = HASH_PRIVATE_KECCAK_ROL32((Aki0 ^ Di0), 21);
+        Bki0 = HASH_PRIVATE_KECCAK_ROL32((Ako1 ^ Do1), 13); Bki1 = HASH_PRIVATE_KECCAK_ROL32((Ako0 ^ Do0), 12);
+        Bsi0 = HASH_PRIVATE_KECCAK_ROL32((Aku1 ^ Du1), 20); Bsi1 = HASH_PRIVATE_KECCAK_ROL32((Aku0 ^ Du0), 19);
+        Bso0 = HASH_PRIVATE_KECCAK_ROL32((Ama1 ^ Da1), 21); Bso1 = HASH_PRIVATE_KECCAK_ROL32((Ama0 ^ Da0), 20);
+        Bgo0 = HASH_PRIVATE_KECCAK_ROL32((Ame1 ^ De1), 23); Bgo1 = HASH_PRIVATE_KECCAK_ROL32((Ame0 ^ De0), 22);
+        Bmo0 = HASH_PRIVATE_KECCAK_ROL32((Ami1 ^ Di1), 8); Bmo1 = HASH_PRIVATE_KECCAK_ROL32((Ami0 ^ Di0), 7);
+        Bbo0 = HASH_PRIVATE_KECCAK_ROL32((Amo1 ^ Do1), 11); Bbo1 = HASH_PRIVATE_KECCAK_ROL32((Amo0 ^ Do0), 10);
+        Bko0 = HASH_PRIVATE_KECCAK_ROL32((Amu0 ^ Du0), 4); Bko1 = HASH_PRIVATE_KECCAK_ROL32((Amu1 ^ Du1), 4);
+        Bku0 = HASH_PRIVATE_KECCAK_ROL32((Asa0 ^ Da0), 9); Bku1 = HASH_PRIVATE_KECCAK_ROL32((Asa1 ^ Da1), 9);
+        Bsu0 = HASH_PRIVATE_KECCAK_ROL32((Ase0 ^ De0), 1); Bsu1 = HASH_PRIVATE_KECCAK_ROL32((Ase1 ^ De1), 1);
+        Bgu0 = HASH_PRIVATE_KECCAK_ROL32((Asi1 ^ Di1), 31); Bgu1 = HASH_PRIVATE_KECCAK_ROL32((Asi0 ^ Di0), 30);
+        Bmu0 = HASH_PRIVATE_KECCAK_ROL32((Aso0 ^ Do0), 28); Bmu1 = HASH_PRIVATE_KECCAK_ROL32((Aso1 ^ Do1), 28);
+        Bbu0 = HASH_PRIVATE_KECCAK_ROL32((Asu0 ^ Du0), 7); Bbu1 = HASH_PRIVATE_KECCAK_ROL32((Asu1 ^ Du1), 7);
+
+        /* χ and ι */
+        Aba0 = Bba0 ^ (~Bbe0 & Bbi0);
+        Aba1 = Bba1 ^ (~Bbe1 & Bbi1);
+        Abe0 = Bbe0 ^ (~Bbi0 & Bbo0);
+        Abe1 = Bbe1 ^ (~Bbi1 & Bbo1);
+        Abi0 = Bbi0 ^ (~Bbo0 & Bbu0);
+        Abi1 = Bbi1 ^ (~Bbo1 & Bbu1);
+        Abo0 = Bbo0 ^ (~Bbu0 & Bba0);
+        Abo1 = Bbo1 ^ (~Bbu1 & Bba1);
+        Abu0 = Bbu0 ^ (~Bba0 & Bbe0);
+        Abu1 = Bbu1 ^ (~Bba1 & Bbe1);
+        Aga0 = Bga0 ^ (~Bge0 & Bgi0);
+        Aga1 = Bga1 ^ (~Bge1 & Bgi1);
+        Age0 = Bge0 ^ (~Bgi0 & Bgo0);
+        Age1 = Bge1 ^ (~Bgi1 & Bgo1);
+        Agi0 = Bgi0 ^ (~Bgo0 & Bgu0);
+        Agi1 = Bgi1 ^ (~Bgo1 & Bgu1);
+        Ago0 = Bgo0 ^ (~Bgu0 & Bga0);
+        Ago1 = Bgo1 ^ (~Bgu1 & Bga1);
+        Agu0 = Bgu0 ^ (~Bga0 & Bge0);
+        Agu1 = Bgu1 ^ (~Bga1 & Bge1);
+        Aka0 = Bka0 ^ (~Bke0 & Bki0);
+        Aka1 = Bka1 ^ (~Bke1 & Bki1);
+        Ake0 = Bke0 ^ (~Bki0 & Bko0);
+        Ake1 = Bke1 ^ (~Bki1 & Bko1);
+        Aki0 = Bki0 ^ (~Bko0 & Bku0);
+        Aki1 = Bki1 ^ (~Bko1 & Bku1);
+        Ako0 = Bko0 ^ (~Bku0 & Bka0);
+        Ako1 = Bko1 ^ (~Bku1 & Bka1);
+        Aku0 = Bku0 ^ (~Bka0 & Bke0);
+        Aku1 = Bku1 ^ (~Bka1 & Bke1);
+        Ama0 = Bma0 ^ (~Bme0 & Bmi0);
+        Ama1 = Bma1 ^ (~Bme1 & Bmi1);
+        Ame0 = Bme0 ^ (~Bmi0 & Bmo0);
+        Ame1 = Bme1 ^ (~Bmi1 & Bmo1);
+        Ami0 = Bmi0 ^ (~Bmo0 & Bmu0);
+        Ami1 = Bmi1 ^ (~Bmo1 & Bmu1);
+        Amo0 = Bmo0 ^ (~Bmu0 & Bma0);
+        Amo1 = Bmo1 ^ (~Bmu1 & Bma1);
+        Amu0 = Bmu0 ^ (~Bma0 & Bme0);
+        Amu1 = Bmu1 ^ (~Bma1 & Bme1);
+        Asa0 = Bsa0 ^ (~Bse0 & Bsi0);
+        Asa1 = Bsa1 ^ (~Bse1 & Bsi1);
+        Ase0 = Bse0 ^ (~Bsi0 & Bso0);
+        Ase1 = Bse1 ^ (~Bsi1 & Bso1);
+        Asi0 = Bsi0 ^ (~Bso0 & Bsu0);
+        Asi1 = Bsi1 ^ (~Bso1 & Bsu1);
+        Aso0 = Bso0 ^ (~Bsu0 & Bsa0);
+        Aso1 = Bso1 ^ (~Bsu1 & Bsa1);
+        Asu0 = Bsu0 ^ (~Bsa0 & Bse0);
+        Asu1 = Bsu1 ^ (~Bsa1 & Bse1);
+        Aba0 ^= hash_private_keccak_round_constants_interleaved[round][0];
+        Aba1 ^= hash_private_keccak_round_constants_interleaved[round][1];
+    }
+
+    hash_private_keccak_WRITELANE(0, 0, hash_private_keccak_deinterleave(Aba0, Aba1));
+    hash_private_keccak_WRITELANE(1, 0, hash_private_keccak_deinterleave(Abe0, Abe1));
+    hash_private_keccak_WRITELANE(2, 0, hash_private_keccak_deinterleave(Abi0, Abi1));
+    hash_private_keccak_WRITELANE(3, 0, hash_private_keccak_deinterleave(Abo0, Abo1));
+    hash_private_keccak_WRITELANE(4, 0, hash_private_keccak_deinterleave(Abu0, Abu1));
+    hash_private_keccak_WRITELANE(0, 1, hash_private_keccak_deinterleave(Aga0, Aga1));
+    hash_private_keccak_WRITELANE(1, 1, hash_private_keccak_deinterleave(Age0, Age1));
+    hash_private_keccak_WRITELANE(2, 1, hash_private_keccak_deinterleave(Agi0, Agi1));
+    hash_private_keccak_WRITELANE(3, 1, hash_private_keccak_deinterleave(Ago0, Ago1));
+    hash_private_keccak_WRITELANE(4, 1, hash_private_keccak_deinterleave(Agu0, Agu1));
+    hash_private_keccak_WRITELANE(0, 2, hash_private_keccak_deinterleave(Aka0, Aka1));
+    hash_private_keccak_WRITELANE(1, 2, hash_private_keccak_deinterleave(Ake0, Ake1));
+    hash_private_keccak_WRITELANE(2, 2, hash_private_keccak_deinterleave(Aki0, Aki1));
+    hash_private_keccak_WRITELANE(3, 2, hash_private_keccak_deinterleave(Ako0, Ako1));
+    hash_private_keccak_WRITELANE(4, 2, hash_private_keccak_deinterleave(Aku0, Aku1));
+    hash_private_keccak_WRITELANE(0, 3, hash_private_keccak_deinterleave(Ama0, Ama1));
+    hash_private_keccak_WRITELANE(1, 3, hash_private_keccak_deinterleave(Ame0, Ame1));
+    hash_private_keccak_WRITELANE(2, 3, hash_private_keccak_deinterleave(Ami0, Ami1));
+    hash_private_keccak_WRITELANE(3, 3, hash_private_keccak_deinterleave(Amo0, Amo1));
+    hash_private_keccak_WRITELANE(4, 3, hash_private_keccak_deinterleave(Amu0, Amu1));
+    hash_private_keccak_WRITELANE(0, 4, hash_private_keccak_deinterleave(Asa0, Asa1));
+    hash_private_keccak_WRITELANE(1, 4, hash_private_keccak_deinterleave(Ase0, Ase1));
+    hash_private_keccak_WRITELANE(2, 4, hash_private_keccak_deinterleave(Asi0, Asi1));
+    hash_private_keccak_WRITELANE(3, 4, hash_private_keccak_deinterleave(Aso0, Aso1));
+    hash_private_keccak_WRITELANE(4, 4, hash_private_keccak_deinterleave(Asu0, Asu1));
+}
+#undef HASH_PRIVATE_KECCAK_ROL32
+#else
 /**
   * Function that computes the linear feedback shift register (LFSR) used to
   * define the round constants (see [Keccak Reference, Section 1.2]).
@@ -3074,6 +5052,7 @@ HASH_INLINE void hash_private_keccak_KeccakF1600_StatePermute(void* state)
         }
     }
 }
+#endif // HASH_KECCAK_UNROLLED
 
 /*
 ================================================================
@@ -3083,55 +5062,101 @@ that use the Keccak-f[1600] permutation.
 */
 
 #define HASH_PRIVATE_KECCAK_MIN(a, b) ((a) < (b) ? (a) : (b))
-HASH_INLINE void hash_private_keccak_Keccak(unsigned int rate, unsigned int capacity, const unsigned char* input, unsigned long long int inputByteLen, unsigned char delimitedSuffix, unsigned char* output, unsigned long long int outputByteLen)
+HASH_INLINE void hash_private_keccak_init(Hash_Private_Keccak* k, unsigned int rate, unsigned char delimitedSuffix)
 {
-    uint8_t state[200];
-    unsigned int rateInBytes = rate / 8;
-    unsigned int blockSize = 0;
-    unsigned int i;
-
-    if (((rate + capacity) != 1600) || ((rate % 8) != 0))
-        return;
+    memset(k->state, 0, sizeof(k->state));
+    k->rateInBytes = rate / 8;
+    k->offset = 0;
+    k->delimitedSuffix = delimitedSuffix;
+    k->squeezing = 0;
+}
 
-    /* === Initialize the state === */
-    memset(state, 0, sizeof(state));
+/* === Absorb the input, a partial block is kept in the state until more input arrives === */
+HASH_INLINE void hash_private_keccak_absorb(Hash_Private_Keccak* k, const unsigned char* input, size_t size)
+{
+    uint8_t* state = (uint8_t*)k->state;
+    unsigned int i;
 
-    /* === Absorb all the input blocks === */
-    while (inputByteLen > 0) {
-        blockSize = (unsigned int)HASH_PRIVATE_KECCAK_MIN(inputByteLen, rateInBytes);
+    while (size > 0) {
+        const unsigned int blockSize = (unsigned int)HASH_PRIVATE_KECCAK_MIN(size, (size_t)(k->rateInBytes - k->offset));
+#if HASH_KECCAK_LITTLE_ENDIAN == 1
+        if ((k->offset % 8) == 0 && blockSize >= 8) {
+            /* Whole lanes at once, the rate is a multiple of the lane size */
+            const unsigned int lanes = blockSize / 8;
+            for (i = 0; i < lanes; i++) {
+                uint64_t lane;
+                memcpy(&lane, &input[8 * i], 8);
+                k->state[k->offset / 8 + i] ^= lane;
+            }
+            for (i = 8 * lanes; i < blockSize; i++)
+                state[k->offset + i] ^= input[i];
+        }
+        else
+#endif
         for (i = 0; i < blockSize; i++)
-            state[i] ^= input[i];
+            state[k->offset + i] ^= input[i];
         input += blockSize;
-        inputByteLen -= blockSize;
+        size -= blockSize;
+        k->offset += blockSize;
 
-        if (blockSize == rateInBytes) {
+        if (k->offset == k->rateInBytes) {
             hash_private_keccak_KeccakF1600_StatePermute(state);
-            blockSize = 0;
+            k->offset = 0;
         }
     }
+}
+
+/* === Do the padding and switch to the squeezing phase, does nothing if already squeezing === */
+HASH_INLINE void hash_private_keccak_finalize(Hash_Private_Keccak* k)
+{
+    uint8_t* state = (uint8_t*)k->state;
+    if (k->squeezing)
+        return;
 
-    /* === Do the padding and switch to the squeezing phase === */
     /* Absorb the last few bits and add the first bit of padding (which coincides with the delimiter in delimitedSuffix) */
-    state[blockSize] ^= delimitedSuffix;
+    state[k->offset] ^= k->delimitedSuffix;
     /* If the first bit of padding is at position rate-1, we need a whole new block for the second bit of padding */
-    if (((delimitedSuffix & 0x80) != 0) && (blockSize == (rateInBytes - 1)))
+    if (((k->delimitedSuffix & 0x80) != 0) && (k->offset == (k->rateInBytes - 1)))
         hash_private_keccak_KeccakF1600_StatePermute(state);
     /* Add the second bit of padding */
-    state[rateInBytes - 1] ^= 0x80;
+    state[k->rateInBytes - 1] ^= 0x80;
     /* Switch to the squeezing phase */
     hash_private_keccak_KeccakF1600_StatePermute(state);
+    k->offset = 0;
+    k->squeezing = 1;
+}
 
-    /* === Squeeze out all the output blocks === */
-    while (outputByteLen > 0) {
-        blockSize = (unsigned int)HASH_PRIVATE_KECCAK_MIN(outputByteLen, rateInBytes);
-        memcpy(output, state, blockSize);
-        output += blockSize;
-        outputByteLen -= blockSize;
+/* === Squeeze out the next output bytes, the state is only permuted once more output is requested === */
+HASH_INLINE void hash_private_keccak_squeeze(Hash_Private_Keccak* k, unsigned char* output, size_t size)
+{
+    uint8_t* state = (uint8_t*)k->state;
+    hash_private_keccak_finalize(k);
 
-        if (outputByteLen > 0)
+    while (size > 0) {
+        if (k->offset == k->rateInBytes) {
             hash_private_keccak_KeccakF1600_StatePermute(state);
+            k->offset = 0;
+        }
+
+        const unsigned int blockSize = (unsigned int)HASH_PRIVATE_KECCAK_MIN(size, (size_t)(k->rateInBytes - k->offset));
+        memcpy(output, &state[k->offset], blockSize);
+        output += blockSize;
+        size -= blockSize;
+        k->offset += blockSize;
     }
 }
+
+HASH_INLINE void hash_private_keccak_Keccak(unsigned int rate, unsigned int capacity, const unsigned char* input, unsigned long long int inputByteLen, unsigned char delimitedSuffix, unsigned char* output, unsigned long long int outputByteLen)
+{
+    Hash_Private_Keccak k;
+
+    if (((rate + capacity) != 1600) || ((rate % 8) != 0))
+        return;
+
+    hash_private_keccak_init(&k, rate, delimitedSuffix);
+    hash_private_keccak_absorb(&k, input, (size_t)inputByteLen);
+    hash_private_keccak_squeeze(&k, output, (size_t)outputByteLen);
+}
 #undef HASH_PRIVATE_KECCAK_I
 #undef HASH_PRIVATE_KECCAK_MIN
 #undef HASH_PRIVATE_KECCAK_ROL64
@@ -3149,10 +5174,54 @@ HASH_INLINE void hash_private_keccak_Keccak(unsigned int rate, unsigned int capa
 #undef HASH_ENABLE_C_INTERFACE
 #undef HASH_ENABLE_CPP_INTERFACE
 #undef HASH_KECCAK_LITTLE_ENDIAN
+#undef HASH_KECCAK_UNROLLED
 #undef HASH_SHAKE_128_MALLOC_LIMIT
 #undef HASH_SHAKE_256_MALLOC_LIMIT
+#undef HASH_THREAD_LOCAL_BUFFERS
+#undef HASH_SHA2_ESP32_HARDWARE
+#undef HASH_PRIVATE_SHA2_ESP32
+#undef HASH_PRIVATE_MBEDTLS
+#undef HASH_SHA256_CPU_EXTENSIONS
+#undef HASH_PRIVATE_SHA256_ACCEL
+#undef HASH_PRIVATE_X86
+#undef HASH_PRIVATE_X86_SHA
+#undef HASH_PRIVATE_X86_AVX2
+#undef HASH_PRIVATE_X86_AVX512
+#undef HASH_PRIVATE_ARM64
+#undef HASH_SHA512_MULTI_BUFFER
+#undef HASH_SHA512_TREE
+#undef HASH_SHA512_TREE_CHUNK_SIZE
+#undef HASH_PRIVATE_TARGET
+#undef HASH_INTERNAL_BUFFER
+#undef HASH_FILE_CHUNK_SIZE
+#undef HASH_FILE_MMAP
+#undef HASH_PRIVATE_MMAP
+#undef HASH_PRIVATE_FILE_SLICE
 #undef HASH_INLINE
 #undef HASH_DEFINE_UTIL_SWAP_ENDIAN
+#undef HASH_PRIVATE_SHA512_MB_DEFINE
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_LOAD
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_STORE
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_SET1
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_ADD
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_XOR
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_AND
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_ANDNOT
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_SHR
+#undef HASH_PRIVATE_SHA512_MB_SCALAR_ROR
+#undef HASH_PRIVATE_SHA512_MB_AVX2_LOAD
+#undef HASH_PRIVATE_SHA512_MB_AVX2_STORE
+#undef HASH_PRIVATE_SHA512_MB_AVX2_SET1
+#undef HASH_PRIVATE_SHA512_MB_AVX2_SHR
+#undef HASH_PRIVATE_SHA512_MB_AVX2_ROR
+#undef HASH_PRIVATE_SHA512_MB_AVX512_LOAD
+#undef HASH_PRIVATE_SHA512_MB_AVX512_STORE
+#undef HASH_PRIVATE_SHA512_MB_AVX512_SET1
+#undef HASH_PRIVATE_SHA512_MB_AVX512_ANDNOT
+#undef HASH_PRIVATE_SHA512_MB_AVX512_SHR
+#undef HASH_PRIVATE_SHA512_MB_AVX512_ROR
+#undef HASH_PRIVATE_SHA512_MB_NEON_ANDNOT
+#undef HASH_PRIVATE_SHA512_MB_NEON_ROR
 
 #pragma GCC diagnostic pop
 
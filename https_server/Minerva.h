@@ -0,0 +1,1142 @@
+#ifndef MINERVA_H
+#define MINERVA_H
+/*
+    The request handlers of the server, shared by every front end
+    https_server.ino and https_server_oled.ino serve them on the ESP32 with esp32_https_server,
+    linux/minerva_server.cpp serves them on Linux with epoll and OpenSSL
+
+    A front end implements Minerva::Request and Minerva::Response on top of its http library and calls
+    the handlers with them, Authenticate is the middleware that runs before every handler:
+
+        Minerva::Begin(LOGIN_USER, LOGIN_KEY); // once before serving
+        Minerva::Authenticate(request, response, [&] { Minerva::HandleGet(request, response); });
+
+    All state (trackers, history, sessions, penalties) lives in this header, include it in exactly one
+    translation unit. A front end that calls handlers from several threads has to serialize them, Authenticate
+    included, both front ends run them under one mutex. The exception are the handlers IsLockFree() names,
+    they only read the seqlocks and the published device slots, so a front end runs them outside of its lock
+    once Authenticate let the request through. App polls are served that way while a tracker uploads.
+    A long-poll is held with Request::Hold, the front end serves other requests meanwhile and calls its
+    respond() later like a handler.
+
+    Written in C++11 so it builds with every version of the ESP32 arduino core
+*/
+
+// Called with a short message when a request is rejected for a reason worth showing, e.g. on a display
+#ifndef MINERVA_REPORT_ERROR
+#define MINERVA_REPORT_ERROR(message)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#if defined(ESP_PLATFORM)
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#endif
+
+#include "Hash.h"
+
+namespace Minerva
+{
+    enum Status
+    {
+        Ok = 200,
+        SettingsChanged = 201,
+        SettingsPending = 202,
+        SettingsApplied = 203,
+        Error = 204,
+        NotModified = 304,
+        SessionExpired = 401 // the bearer token is unknown or expired, POST /login again
+    };
+
+
+    class Response;
+
+    // What the handlers need of a request, the names follow esp32_https_server's HTTPRequest
+    class Request
+    {
+    public:
+        virtual ~Request() = default;
+
+        virtual std::string GetHeader(const std::string& name) = 0; // "" if it's missing
+        virtual bool GetQueryParameter(const std::string& name, std::string& value) = 0;
+        virtual std::string GetBasicAuthUser() = 0;
+        virtual std::string GetBasicAuthPassword() = 0;
+        virtual uint32_t GetClientIP() = 0;
+
+        virtual size_t ReadBytes(uint8_t* buffer, size_t size) = 0;
+        virtual bool RequestComplete() = 0;
+        virtual void DiscardRequestBody() = 0;
+
+        // Holds the request until changed() returns true or the timeout ran out, then respond() writes the response
+        // to the Response of this request. The handler returns right after calling it, the front end may call
+        // respond() before Hold() returns or later from its event loop. Both outlive the handler, capture by value.
+        // changed() only looks at the tracker of the request (DeviceId()), it can't turn true before the changes
+        // of that tracker move, so a front end may skip it until then. Only the handlers of IsLockFree() hold,
+        // they call Hold() without the lock and changed() and respond() may run without it as well.
+        virtual void Hold(std::function<bool()> changed, unsigned long timeoutMs, std::function<void(Response&)> respond) = 0;
+    };
+
+
+    class Response
+    {
+    public:
+        virtual ~Response() = default;
+
+        virtual void SetStatusCode(uint16_t code) = 0;
+        virtual void SetStatusText(const std::string& text) = 0;
+        virtual void SetHeader(const std::string& name, const std::string& value) = 0;
+        virtual void Write(const uint8_t* data, size_t size) = 0;
+
+        // every line the handlers print is short, longer output is cut
+        void Printf(const char* format, ...)
+        {
+            char buffer[256];
+            va_list args;
+            va_start(args, format);
+            const int size = vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            if (size > 0)
+                Write((const uint8_t*)buffer, std::min((size_t)size, sizeof(buffer) - 1));
+        }
+    };
+
+
+    // millis() on the ESP32, wraps after 49 days everywhere so the time math is the same
+    inline uint32_t Millis()
+    {
+#if defined(ESP_PLATFORM)
+        return millis();
+#else
+        static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+#endif
+    }
+
+    // lets the other tasks run while waiting for another one
+    inline void Yield()
+    {
+#if defined(ESP_PLATFORM)
+        taskYIELD();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    inline void FillRandom(void* buffer, size_t size)
+    {
+#if defined(ESP_PLATFORM)
+        esp_fill_random(buffer, size);
+#else
+        for (size_t i = 0; i < size; i += 256) // getentropy returns at most 256 bytes per call
+        {
+            if (getentropy((uint8_t*)buffer + i, std::min(size - i, (size_t)256)) != 0)
+                abort(); // no session token is better than a predictable one
+        }
+#endif
+    }
+
+
+    constexpr size_t dataSize = 37;
+
+    // A fix as it's stored and as it's sent in the binary format, the ESP32 is little endian
+    // so it goes over the wire as it is. Clients opt in with "Content-Type: application/vnd.minerva.fix"
+    // for uploads and "Accept: application/vnd.minerva.fix" for GET / and /history.
+    struct Fix
+    {
+        uint8_t version; // binaryFixVersion, 0 = no fix yet
+        uint8_t kmh;
+        int16_t alt;     // meter
+        int32_t lat;     // 1e-7 degrees, about 1 cm, ±180° still fits an int32
+        int32_t lng;     // 1e-7 degrees
+        uint32_t time;   // Millis() when it was taken, POST and GET / use the age in ms instead
+    };
+    static_assert(sizeof(Fix) == 16, "Fix is sent as it is");
+    constexpr uint8_t binaryFixVersion = 2; // 1 had lat and lng in microdegrees
+    constexpr const char* binaryFixType = "application/vnd.minerva.fix";
+    constexpr size_t fixTextSize = 48; // "lat,lng,alt,kmh" with 7 decimals
+
+    // GET / tags its response with W/"<boot id>-<fix count>", so a client that sends it back in If-None-Match
+    // gets an empty 304 until a newer fix arrives. The boot id keeps a count from before a restart from matching.
+    constexpr size_t etagSize = 32;
+    uint32_t bootId = 0;
+
+    constexpr size_t batchLineSize = 8 + 1 + dataSize; // "age," + fix
+
+    constexpr size_t settingsDataSize = 29;
+
+    // Publishes a small value without locking out its readers: a write makes the sequence odd, copies the value and
+    // makes it even again, a read copies the value and retries if the sequence was odd or changed in the meantime.
+    // Readers never block a writer and never see half of a write, even on the other core. Writers take the odd
+    // sequence with a compare-exchange, so writers from several tasks are serialized instead of interleaved.
+    // A writer preempted while the sequence is odd keeps the others waiting until it runs again, so they yield while
+    // they wait. On the ESP32 a write runs in a critical section instead, nothing preempts it there and the writers
+    // of both cores take turns on the spinlock.
+#if defined(ESP_PLATFORM)
+    portMUX_TYPE seqlockMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+    template <typename T>
+    struct Seqlock
+    {
+        std::atomic<uint32_t> sequence;
+        T value;
+
+        T Read() const
+        {
+            for (;;)
+            {
+                const uint32_t before = sequence.load(std::memory_order_acquire);
+                T copy = value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((before & 1) == 0 && sequence.load(std::memory_order_relaxed) == before)
+                    return copy;
+                Yield();
+            }
+        }
+
+        // modify(value) runs while the sequence is odd, keep it short and don't block in it, readers wait meanwhile
+        template <typename F>
+        void Update(F modify)
+        {
+#if defined(ESP_PLATFORM)
+            portENTER_CRITICAL(&seqlockMux);
+            const uint32_t current = sequence.load(std::memory_order_relaxed);
+            sequence.store(current + 1, std::memory_order_relaxed);
+#else
+            uint32_t current = sequence.load(std::memory_order_relaxed);
+            while ((current & 1) != 0 || !sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                Yield();
+                current = sequence.load(std::memory_order_relaxed);
+            }
+#endif
+            std::atomic_thread_fence(std::memory_order_release);
+            modify(value);
+            sequence.store(current + 2, std::memory_order_release);
+#if defined(ESP_PLATFORM)
+            portEXIT_CRITICAL(&seqlockMux);
+#endif
+        }
+    };
+
+    // Every tracker gets a slot on its first upload or settings change. Requests pick it with "?id=<tracker id>",
+    // without an id they go to the "" tracker so a single tracker works as before. The table is open addressed
+    // and never filled beyond 3/4, so a lookup is a hash and a few probes.
+    constexpr size_t deviceIdSize = 16;
+    constexpr size_t maxDevices = 48; // same limit as MaxDevices of server.go
+    constexpr size_t deviceSlots = 64; // power of 2
+    static_assert(maxDevices <= deviceSlots / 4 * 3 && (deviceSlots & (deviceSlots - 1)) == 0, "slots are masked, 1/4 stays free");
+
+    // The fixes of a tracker ordered by the time they were taken. They are kept in a list of blocks from a shared pool,
+    // a tracker takes the next free block whenever its newest one is full. Once the pool is handed out, the tracker with
+    // the most blocks gives its oldest one to the tracker that needs one, or moves its own oldest block to the end if no
+    // tracker has more. A single tracker keeps the whole pool this way and a fleet ends up with an even share each.
+    constexpr size_t historyFixes = 1536; // of all trackers together, 30 KB
+    constexpr size_t historyBlockSize = 8; // fixes, a tracker drops this many at once
+    constexpr size_t historyBlocks = historyFixes / historyBlockSize;
+    static_assert(historyBlocks >= 4 * maxDevices && historyBlocks <= 256, "a full fleet keeps 3 to 4 blocks each, blocks are uint8_t");
+    struct HistoryBlock
+    {
+        Fix fixes[historyBlockSize];
+        uint32_t sequences[historyBlockSize]; // of fixes, the count when it arrived, GET /history?after= is based on it
+        uint8_t prev; // neighbours in the list of its tracker
+        uint8_t next;
+    };
+    HistoryBlock historyPool[historyBlocks] = {};
+    size_t historyBlocksUsed = 0; // the ones after it haven't been handed out yet
+    struct History
+    {
+        uint8_t oldest; // blocks of historyPool, only valid with a blockCount
+        uint8_t newest;
+        size_t blockCount;
+        size_t base;  // number of the oldest fix that is kept, the first one in the oldest block
+        size_t count; // fixes received since boot, the newest one is number count - 1
+    };
+    History histories[maxDevices] = {};
+    struct DeviceFix
+    {
+        Fix fix;         // latest fix
+        uint32_t fixes;  // times fix was replaced since boot, the ETag of GET / and what its long-poll waits for
+        char text[fixTextSize]; // fix rendered for GET / by AddFix, "" until the first fix
+    };
+    struct DeviceSettings
+    {
+        char data[settingsDataSize + 1];
+        bool changed;
+    };
+    // A slot is only taken with the lock of the front end held and published by the release store of used, a lookup
+    // without the lock sees it not at all or with its id. fix and settings may be read without the lock, the rest not.
+    struct Device
+    {
+        std::atomic<bool> used;
+        char id[deviceIdSize + 1];
+        Seqlock<DeviceFix> fix;
+        Seqlock<DeviceSettings> settings;
+        std::atomic<uint32_t> changes; // fixes and settings updates since boot, moves after the update, see Request::Hold
+        History* history; // one of histories
+    };
+    Device devices[deviceSlots] = {};
+    size_t deviceCount = 0;
+
+    constexpr unsigned long longPollMaxMs = 20000;
+
+    std::string loginUser;
+    uint8_t loginKey[64] = { 0 }; // sha512 of the password as raw digest
+
+    // failed logins per ip, requests of a penalized ip are dropped right away instead of
+    // delaying the response so a scanner can't stall the tracker and the app
+    struct Penalty
+    {
+        uint32_t ip;
+        uint8_t failures;
+        uint32_t until;
+    };
+    constexpr size_t penaltySlots = 16;
+    constexpr uint32_t maxPenaltyMs = 30000;
+    Penalty penalties[penaltySlots] = {};
+
+    // POST /login hands out random session tokens, requests with "Authorization: Bearer <token>"
+    // are checked by a constant time compare instead of hashing the password again. There is a slot for
+    // every tracker and a few app clients, a token that was replaced or ran out gets Status::SessionExpired.
+    struct Session
+    {
+        uint8_t token[16];
+        uint32_t expires;
+        bool used;
+    };
+    constexpr size_t appSessions = 16;
+    constexpr size_t sessionSlots = maxDevices + appSessions;
+    constexpr uint32_t sessionLifetimeMs = 60UL * 60 * 1000;
+    Session sessions[sessionSlots] = {};
+
+    // for the metrics of the front ends
+    struct Counters
+    {
+        std::atomic<uint32_t> authFailures; // wrong user or password
+        std::atomic<uint32_t> penalized;    // requests dropped because their ip is penalized
+        std::atomic<uint32_t> expiredSessions; // bearer tokens that were unknown or expired
+    };
+    Counters counters = {};
+
+
+    // Call once before serving: picks the boot id and sets the login of Authenticate, key is the sha512
+    // of the password as hex string. False if the key isn't one, every login fails then.
+    inline bool Begin(const char* user, const char* key)
+    {
+        FillRandom(&bootId, sizeof(bootId));
+        loginUser = user;
+        return hash_util_hex_string_to_char_array(key, sizeof(loginKey), loginKey);
+    }
+
+
+    inline Penalty* FindPenalty(uint32_t ip)
+    {
+        for (Penalty& p : penalties)
+        {
+            if (p.failures != 0 && p.ip == ip)
+                return &p;
+        }
+        return nullptr;
+    }
+
+
+    inline bool IsPenalized(uint32_t ip)
+    {
+        const Penalty* p = FindPenalty(ip);
+        return p != nullptr && (int32_t)(p->until - Millis()) > 0;
+    }
+
+
+    inline void AddFailure(uint32_t ip)
+    {
+        Penalty* p = FindPenalty(ip);
+        if (p == nullptr)
+        {
+            // take a free slot or the one whose penalty ran out first
+            p = &penalties[0];
+            for (Penalty& slot : penalties)
+            {
+                if (slot.failures == 0)
+                {
+                    p = &slot;
+                    break;
+                }
+                if ((int32_t)(slot.until - p->until) < 0)
+                    p = &slot;
+            }
+            *p = { ip, 0, 0 };
+        }
+
+        if (p->failures < 255)
+            ++p->failures;
+        // 1s, 2s, 4s ... doubled per failure up to maxPenaltyMs, plus up to 1s of jitter
+        uint16_t jitter;
+        FillRandom(&jitter, sizeof(jitter));
+        const uint32_t penalty = std::min(maxPenaltyMs, (uint32_t)1000 << std::min(p->failures - 1, 5));
+        p->until = Millis() + penalty + jitter % 1000;
+    }
+
+
+    inline void ClearFailures(uint32_t ip)
+    {
+        Penalty* p = FindPenalty(ip);
+        if (p != nullptr)
+            *p = {};
+    }
+
+
+    inline void Reject(Request& req, Response& res)
+    {
+        req.DiscardRequestBody();
+        res.SetStatusCode(Status::Error);
+        res.SetHeader("Connection", "close");
+    }
+
+
+    inline bool IsBearer(const std::string& authorization)
+    {
+        return authorization.compare(0, 7, "Bearer ") == 0;
+    }
+
+
+    inline bool IsValidSession(const std::string& authorization)
+    {
+        // "Bearer <32 hex chars>"
+        static const std::string bearer = "Bearer ";
+        uint8_t token[sizeof(Session::token)];
+        if (authorization.size() != bearer.size() + 2 * sizeof(token) || !IsBearer(authorization)
+            || !hash_util_hex_string_to_char_array(authorization.c_str() + bearer.size(), sizeof(token), token))
+            return false;
+
+        // every slot is compared so the time doesn't tell which one matched
+        bool valid = false;
+        const uint32_t now = Millis();
+        for (const Session& session : sessions)
+        {
+            if (hash_util_digest_equal(session.token, token, sizeof(token)) & session.used & ((int32_t)(session.expires - now) > 0))
+                valid = true;
+        }
+        return valid;
+    }
+
+
+    inline void Authenticate(Request& req, Response& res, const std::function<void()>& next)
+    {
+        const uint32_t ip = req.GetClientIP();
+        if (IsPenalized(ip))
+        {
+            ++counters.penalized;
+            Reject(req, res); // no hashing while it's penalized
+            return;
+        }
+
+        // A token is 128 random bits, guessing one is hopeless, so a wrong one isn't a failed login. It's most likely
+        // a client whose session ran out or was replaced, it gets its own status to log in again and no penalty.
+        const std::string authorization = req.GetHeader("Authorization");
+        if (IsBearer(authorization))
+        {
+            if (IsValidSession(authorization))
+                next();
+            else
+            {
+                ++counters.expiredSessions;
+                req.DiscardRequestBody();
+                res.SetStatusCode(Status::SessionExpired);
+                res.SetStatusText("Unauthorized");
+            }
+            return;
+        }
+
+        const std::string password = req.GetBasicAuthPassword();
+        Hash_Sha512 s;
+        hash_sha512_init(s);
+        hash_sha512_update_binary(s, password.c_str(), password.size());
+        hash_sha512_finalize(s);
+
+        uint8_t digest[64];
+        hash_sha512_digest(s, digest);
+        if (hash_util_digest_equal(digest, loginKey, sizeof(digest)) && req.GetBasicAuthUser() == loginUser)
+        {
+            ClearFailures(ip);
+            next();
+        }
+        else
+        {
+            ++counters.authFailures;
+            AddFailure(ip);
+            Reject(req, res);
+        }
+    }
+
+
+    inline bool IsValidDeviceId(const std::string& id)
+    {
+        // the id is sent back in the lines of GET /devices, separators and control characters would break them
+        for (char c : id)
+        {
+            if (c == ',' || (uint8_t)c < 0x20 || c == 0x7f)
+                return false;
+        }
+        return true;
+    }
+
+
+    inline Device* FindDevice(const std::string& id, bool create)
+    {
+        if (id.size() > deviceIdSize)
+            return nullptr;
+
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (char c : id)
+            hash = (hash ^ (uint8_t)c) * 16777619u;
+
+        for (size_t i = hash & (deviceSlots - 1);; i = (i + 1) & (deviceSlots - 1))
+        {
+            Device& device = devices[i];
+            if (!device.used.load(std::memory_order_acquire))
+            {
+                if (!create || deviceCount >= maxDevices || !IsValidDeviceId(id))
+                    return nullptr;
+                memcpy(device.id, id.c_str(), id.size() + 1);
+                device.history = &histories[deviceCount];
+                ++deviceCount;
+                device.used.store(true, std::memory_order_release);
+                return &device;
+            }
+            if (id == device.id)
+                return &device;
+        }
+    }
+
+
+    inline std::string DeviceId(Request& req)
+    {
+        std::string id;
+        req.GetQueryParameter("id", id);
+        return id;
+    }
+
+
+    inline const Device& ReadDevice(const std::string& id)
+    {
+        // unknown trackers read as one that never sent anything
+        static const Device none = {};
+        const Device* device = FindDevice(id, false);
+        return device == nullptr ? none : *device;
+    }
+
+
+    inline bool IsValidFix(const Fix& fix)
+    {
+        return fix.version == binaryFixVersion
+            && fix.lat >= -900000000 && fix.lat <= 900000000
+            && fix.lng >= -1800000000 && fix.lng <= 1800000000;
+    }
+
+
+    inline bool ParseFix(const char* text, Fix& fix)
+    {
+        // "lat,lng,alt,kmh"
+        char* end = nullptr;
+        const double lat = strtod(text, &end);
+        if (end == text || *end != ',')
+            return false;
+        text = end + 1;
+        const double lng = strtod(text, &end);
+        if (end == text || *end != ',')
+            return false;
+        text = end + 1;
+        const long alt = strtol(text, &end, 10);
+        if (end == text || *end != ',')
+            return false;
+        text = end + 1;
+        const long kmh = strtol(text, &end, 10);
+        if (end == text || *end != 0)
+            return false;
+
+        if (!(std::fabs(lat) <= 90.0) || !(std::fabs(lng) <= 180.0))
+            return false; // out of range would overflow the int32, NaN fails too
+
+        fix.version = binaryFixVersion;
+        fix.lat = (int32_t)std::lround(lat * 1e7);
+        fix.lng = (int32_t)std::lround(lng * 1e7);
+        fix.alt = (int16_t)std::min(std::max(alt, (long)INT16_MIN), (long)INT16_MAX);
+        fix.kmh = (uint8_t)std::min(std::max(kmh, 0L), (long)UINT8_MAX);
+        fix.time = 0;
+        return IsValidFix(fix);
+    }
+
+
+    inline unsigned long Magnitude(int32_t v)
+    {
+        return v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+    }
+
+
+    inline int FormatFix(const Fix& fix, char* buffer, size_t size)
+    {
+        // "lat,lng,alt,kmh", integer math so no float formatting is needed
+        return snprintf(buffer, size, "%s%lu.%07lu,%s%lu.%07lu,%d,%u",
+            fix.lat < 0 ? "-" : "", Magnitude(fix.lat) / 10000000, Magnitude(fix.lat) % 10000000,
+            fix.lng < 0 ? "-" : "", Magnitude(fix.lng) / 10000000, Magnitude(fix.lng) % 10000000,
+            (int)fix.alt, (unsigned)fix.kmh);
+    }
+
+
+    inline void AddHistoryBlock(History& history)
+    {
+        uint8_t block;
+        if (historyBlocksUsed < historyBlocks)
+            block = (uint8_t)historyBlocksUsed++;
+        else
+        {
+            // the pool is handed out, the history with the most blocks gives up its oldest one, this one if no other has more
+            History* from = &history;
+            for (History& other : histories)
+            {
+                if (other.blockCount > from->blockCount)
+                    from = &other;
+            }
+            block = from->oldest;
+            from->oldest = historyPool[block].next;
+            from->base += historyBlockSize;
+            --from->blockCount;
+        }
+
+        if (history.blockCount == 0)
+            history.oldest = block;
+        else
+        {
+            historyPool[history.newest].next = block;
+            historyPool[block].prev = history.newest;
+        }
+        history.newest = block;
+        ++history.blockCount;
+    }
+
+
+    inline void AddFix(Device& device, Fix fix, uint32_t time)
+    {
+        // a batch may carry fixes older than the latest one, those are moved in behind the newer ones
+        fix.time = time;
+        History& history = *device.history;
+        if (history.count == history.base + history.blockCount * historyBlockSize)
+            AddHistoryBlock(history);
+
+        size_t i = history.count;
+        uint8_t block = history.newest; // holds number i
+        for (; i > history.base; --i)
+        {
+            const uint8_t from = i % historyBlockSize == 0 ? historyPool[block].prev : block;
+            const size_t j = (i - 1) % historyBlockSize;
+            if ((int32_t)(historyPool[from].fixes[j].time - time) <= 0)
+                break;
+            historyPool[block].fixes[i % historyBlockSize] = historyPool[from].fixes[j];
+            historyPool[block].sequences[i % historyBlockSize] = historyPool[from].sequences[j];
+            block = from;
+        }
+        historyPool[block].fixes[i % historyBlockSize] = fix;
+        historyPool[block].sequences[i % historyBlockSize] = (uint32_t)++history.count;
+
+        // GET / keeps showing the newest fix of the device
+        const DeviceFix current = device.fix.Read();
+        const bool newest = current.fixes == 0 || (int32_t)(time - current.fix.time) >= 0;
+        char text[fixTextSize];
+        FormatFix(fix, text, sizeof(text));
+        device.fix.Update([&fix, &text, newest](DeviceFix& latest)
+        {
+            if (newest)
+            {
+                latest.fix = fix;
+                memcpy(latest.text, text, sizeof(text));
+                ++latest.fixes; // an older one from a batch leaves GET / and its ETag as they are
+            }
+        });
+        device.changes.fetch_add(1, std::memory_order_release);
+    }
+
+
+    inline bool IsBinaryUpload(Request& req)
+    {
+        return req.GetHeader("Content-Type") == binaryFixType;
+    }
+
+
+    inline bool WantsBinary(Request& req)
+    {
+        return req.GetHeader("Accept").find(binaryFixType) != std::string::npos;
+    }
+
+
+    inline void FormatETag(uint32_t fixes, bool binary, char* buffer, size_t size)
+    {
+        // the binary and the text response of the same fix need different tags
+        snprintf(buffer, size, "W/\"%08lx-%lu%s\"", (unsigned long)bootId, (unsigned long)fixes, binary ? "-b" : "");
+    }
+
+
+    inline bool ReadFix(Request& req, Fix& fix)
+    {
+        // one binary fix, false if the body ended before
+        size_t s = 0;
+        while (s < sizeof(fix) && !req.RequestComplete())
+        {
+            s += req.ReadBytes((uint8_t*)&fix + s, sizeof(fix) - s);
+        }
+        return s == sizeof(fix) && IsValidFix(fix);
+    }
+
+
+    inline bool ReadBytes(Request& req, Response& res, char* buffer, size_t size)
+    {
+        size_t s = 0;
+        while (s < size && !req.RequestComplete())
+        {
+            s += req.ReadBytes((uint8_t*)&buffer[s], size - s);
+        }
+        buffer[s] = 0;
+
+        if (!req.RequestComplete())
+        {
+            MINERVA_REPORT_ERROR("Request is too long");
+            req.DiscardRequestBody();
+            res.SetStatusCode(Status::Error);
+            return false;
+        }
+        return true;
+    }
+
+
+    inline void HandlePost(Request& req, Response& res)
+    {
+        /*
+            Structure: "lat,lng,alt,kmh" or a binary Fix with the age in ms as time, see Fix
+            lat = 13 chars
+            lng = 12 chars
+            alt = 5 chars
+            kmh = 4 chars
+            +3 commas
+
+            37 chars
+            example: "67,49.02536179,11.95466600,436,0"
+
+            Authentication:
+            User: login
+            Pw: 1234
+        */
+
+        Device* device = FindDevice(DeviceId(req), true);
+        if (device == nullptr)
+        {
+            req.DiscardRequestBody();
+            res.SetStatusCode(Status::Error);
+            return;
+        }
+
+        Fix fix;
+        uint32_t time = Millis();
+        if (IsBinaryUpload(req))
+        {
+            if (!ReadFix(req, fix) || !req.RequestComplete())
+            {
+                req.DiscardRequestBody();
+                res.SetStatusCode(Status::Error);
+                return;
+            }
+            time -= fix.time;
+        }
+        else
+        {
+            char buffer[dataSize + 1];
+            if (!ReadBytes(req, res, buffer, dataSize))
+                return;
+            if (!ParseFix(buffer, fix))
+            {
+                res.SetStatusCode(Status::Error);
+                return;
+            }
+        }
+
+        AddFix(*device, fix, time);
+        if (device->settings.Read().changed) res.SetStatusCode(Status::SettingsChanged);
+    }
+
+
+    inline bool AddBatchFix(Device& device, char* line, size_t size, uint32_t now)
+    {
+        // "age,lat,lng,alt,kmh" -> fix from now - age
+        line[size] = 0;
+        char* text = nullptr;
+        const unsigned long age = strtoul(line, &text, 10);
+        Fix fix;
+        if (text == line || *text != ',' || !ParseFix(text + 1, fix))
+            return false;
+
+        AddFix(device, fix, now - age);
+        return true;
+    }
+
+
+    inline void HandlePostBatch(Request& req, Response& res)
+    {
+        /*
+            Structure: "age,lat,lng,alt,kmh\nage,lat,lng,alt,kmh\n..." or binary Fixes one after another
+            age = ms since the fix was taken, max 8 chars, the time of a binary Fix
+            lat,lng,alt,kmh like POST /
+
+            The body is parsed while it's read, so any number of fixes can be sent at once.
+            Invalid lines are skipped, Status::Error is returned if not a single fix was valid.
+        */
+
+        Device* device = FindDevice(DeviceId(req), true);
+        if (device == nullptr)
+        {
+            req.DiscardRequestBody();
+            res.SetStatusCode(Status::Error);
+            return;
+        }
+
+        const uint32_t now = Millis();
+        size_t fixes = 0;
+        if (IsBinaryUpload(req))
+        {
+            Fix fix;
+            while (!req.RequestComplete())
+            {
+                if (ReadFix(req, fix))
+                {
+                    AddFix(*device, fix, now - fix.time);
+                    ++fixes;
+                }
+            }
+            if (fixes == 0) res.SetStatusCode(Status::Error);
+            else if (device->settings.Read().changed) res.SetStatusCode(Status::SettingsChanged);
+            return;
+        }
+
+        char line[batchLineSize + 1];
+        size_t lineSize = 0;
+        bool overlong = false;
+
+        uint8_t chunk[128];
+        while (!req.RequestComplete())
+        {
+            const size_t size = req.ReadBytes(chunk, sizeof(chunk));
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (chunk[i] == '\n')
+                {
+                    if (!overlong && AddBatchFix(*device, line, lineSize, now))
+                        ++fixes;
+                    lineSize = 0;
+                    overlong = false;
+                }
+                else if (lineSize < batchLineSize)
+                    line[lineSize++] = chunk[i];
+                else
+                    overlong = true;
+            }
+        }
+        if (lineSize != 0 && !overlong && AddBatchFix(*device, line, lineSize, now))
+            ++fixes;
+
+        if (fixes == 0) res.SetStatusCode(Status::Error);
+        else if (device->settings.Read().changed) res.SetStatusCode(Status::SettingsChanged);
+    }
+
+
+    inline void HandlePostTrackerSettings(Request& req, Response& res)
+    {
+        /*
+            Structure: "sleep_after_send_ms,sleep_between_samples_ms,samples_before_send,sleep_for_while_no_signal"
+            max number ms: 86399000 // 23 hours, 59 minutes, 59 seconds
+
+            8 chars
+            8 chars
+            2 chars
+            8 chars
+            +3 chars comma
+            29 chars
+        */
+
+        Device* device = FindDevice(DeviceId(req), true);
+        if (device == nullptr)
+        {
+            req.DiscardRequestBody();
+            res.SetStatusCode(Status::Error);
+            return;
+        }
+
+        char buffer[settingsDataSize + 1];
+        if (!ReadBytes(req, res, buffer, settingsDataSize))
+            return;
+        device->settings.Update([&buffer](DeviceSettings& settings)
+        {
+            memcpy(settings.data, buffer, settingsDataSize);
+            settings.changed = true;
+        });
+        device->changes.fetch_add(1, std::memory_order_release);
+    }
+
+
+    inline void HandlePostLogin(Request& req, Response& res)
+    {
+        /*
+            Structure: "token,lifetime_ms"
+            token = 32 hex chars, send it as "Authorization: Bearer <token>" until it expires
+            Once it expired or was replaced by a newer login, requests with it get Status::SessionExpired, log in again then.
+        */
+
+        req.DiscardRequestBody();
+        const uint32_t now = Millis();
+
+        // take a free or expired slot, otherwise the one that expires first
+        Session* session = &sessions[0];
+        for (Session& slot : sessions)
+        {
+            if (!slot.used || (int32_t)(slot.expires - now) <= 0)
+            {
+                session = &slot;
+                break;
+            }
+            if ((int32_t)(slot.expires - session->expires) < 0)
+                session = &slot;
+        }
+
+        FillRandom(session->token, sizeof(session->token));
+        session->expires = now + sessionLifetimeMs;
+        session->used = true;
+
+        char token[2 * sizeof(session->token) + 1];
+        hash_util_char_array_to_hex_string(session->token, sizeof(session->token), token);
+        res.SetHeader("Content-Type", "text/plain");
+        res.Printf("%s,%lu", token, (unsigned long)sessionLifetimeMs);
+    }
+
+
+    inline void HandleGetTrackerSettingsApplied(Request& req, Response&)
+    {
+        req.DiscardRequestBody();
+        Device* device = FindDevice(DeviceId(req), false);
+        if (device != nullptr && device->settings.Read().changed) // writers hold the lock, it can't change meanwhile
+        {
+            device->settings.Update([](DeviceSettings& settings) { settings.changed = false; });
+            device->changes.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+
+    inline Status SettingsStatus(const Device& device)
+    {
+        return device.settings.Read().changed ? Status::SettingsPending : Status::SettingsApplied;
+    }
+
+
+    inline unsigned long LongPollWait(Request& req)
+    {
+        // "?wait=<ms>", 0 if it's not a long-poll
+        std::string wait;
+        if (!req.GetQueryParameter("wait", wait))
+            return 0;
+        return std::min(strtoul(wait.c_str(), nullptr, 10), longPollMaxMs);
+    }
+
+
+    inline void HandleGetTrackerSettingsStatus(Request& req, Response& res)
+    {
+        /*
+            Long-poll: "?wait=<ms>&status=<code>" holds the request while the status is still <code>,
+            without status while it's the one the request arrived with, wait is capped at longPollMaxMs
+        */
+
+        req.DiscardRequestBody();
+        const std::string id = DeviceId(req);
+        const unsigned long wait = LongPollWait(req);
+        const std::function<void(Response&)> respond = [id](Response& res) { res.SetStatusCode(SettingsStatus(ReadDevice(id))); };
+        if (wait != 0)
+        {
+            std::string known;
+            const int from = req.GetQueryParameter("status", known) ? atoi(known.c_str()) : SettingsStatus(ReadDevice(id));
+            req.Hold([id, from] { return SettingsStatus(ReadDevice(id)) != from; }, wait, respond);
+            return;
+        }
+        respond(res);
+    }
+
+
+    inline void HandleGetTrackerSettings(Request& req, Response& res)
+    {
+        req.DiscardRequestBody();
+        res.SetHeader("Content-Type", "text/plain");
+        res.Printf("%s", ReadDevice(DeviceId(req)).settings.Read().data);
+    }
+
+
+    // the response of GET /, also sent once a held GET / is done
+    inline void RespondFix(Response& res, const DeviceFix& latest, bool binary, const std::string& ifNoneMatch)
+    {
+        char etag[etagSize];
+        FormatETag(latest.fixes, binary, etag, sizeof(etag));
+        res.SetHeader("ETag", etag);
+        if (ifNoneMatch.find(etag) != std::string::npos)
+        {
+            res.SetStatusCode(Status::NotModified);
+            res.SetStatusText("Not Modified");
+            return;
+        }
+
+        const uint32_t age = Millis() - latest.fix.time;
+        if (binary)
+        {
+            Fix fix = latest.fix;
+            fix.time = age;
+            res.SetHeader("Content-Type", binaryFixType);
+            res.Write((const uint8_t*)&fix, sizeof(fix));
+            return;
+        }
+
+        // the age is the only part that isn't rendered yet
+        res.SetHeader("Content-Type", "text/plain");
+        res.Printf("%lu,%s", (unsigned long)age, latest.text);
+    }
+
+
+    inline void HandleGet(Request& req, Response& res)
+    {
+        /*
+            Structure: "age,lat,lng,alt,kmh" or a binary Fix with the age in ms as time
+            age = ms since the fix was taken
+
+            Long-poll: "?wait=<ms>" holds the request until a new fix arrives, capped at longPollMaxMs
+
+            Conditional: send the ETag of the last response as If-None-Match, the response is an empty
+            Status::NotModified while there is no new fix, with wait only once the wait is over
+        */
+
+        req.DiscardRequestBody();
+        const std::string id = DeviceId(req);
+        const bool binary = WantsBinary(req);
+        const std::string ifNoneMatch = req.GetHeader("If-None-Match");
+        const std::function<void(Response&)> respond = [id, binary, ifNoneMatch](Response& res) { RespondFix(res, ReadDevice(id).fix.Read(), binary, ifNoneMatch); };
+        const unsigned long wait = LongPollWait(req);
+        if (wait != 0)
+        {
+            const uint32_t count = ReadDevice(id).fix.Read().fixes;
+            req.Hold([id, count] { return ReadDevice(id).fix.Read().fixes != count; }, wait, respond);
+            return;
+        }
+        respond(res);
+    }
+
+
+    inline void HandleGetHistory(Request& req, Response& res)
+    {
+        /*
+            Structure: "now,sequence\ntime,lat,lng,alt,kmh\ntime,lat,lng,alt,kmh\n..."
+            now = Millis() of the server
+            sequence = fixes the server received from this tracker so far
+            time = Millis() when the fix was taken, oldest fix first
+            Binary: now and sequence as uint32 followed by the Fixes
+
+            Only the fixes that arrived after "?after=<sequence>" are sent, pass the sequence of the
+            last response to fetch just the new ones, without it the whole history is sent.
+            A batch may bring fixes older than ones already sent, they are still sent once.
+        */
+
+        req.DiscardRequestBody();
+        const uint32_t now = Millis();
+        const Device* device = FindDevice(DeviceId(req), false);
+        static const History none = {};
+        const History& history = device == nullptr ? none : *device->history;
+        const uint32_t sequence = (uint32_t)history.count;
+
+        std::string after;
+        const uint32_t cursor = req.GetQueryParameter("after", after) ? strtoul(after.c_str(), nullptr, 10) : 0;
+
+        const bool binary = WantsBinary(req);
+        if (binary)
+        {
+            res.SetHeader("Content-Type", binaryFixType);
+            res.Write((const uint8_t*)&now, sizeof(now));
+            res.Write((const uint8_t*)&sequence, sizeof(sequence));
+        }
+        else
+        {
+            res.SetHeader("Content-Type", "text/plain");
+            res.Printf("%lu,%lu\n", (unsigned long)now, (unsigned long)sequence);
+        }
+
+        char text[fixTextSize];
+        uint8_t block = history.oldest;
+        for (size_t i = history.base; i < history.count; ++i)
+        {
+            if (i != history.base && i % historyBlockSize == 0)
+                block = historyPool[block].next;
+            if (historyPool[block].sequences[i % historyBlockSize] <= cursor)
+                continue;
+            const Fix& fix = historyPool[block].fixes[i % historyBlockSize];
+            if (binary)
+                res.Write((const uint8_t*)&fix, sizeof(fix));
+            else
+            {
+                FormatFix(fix, text, sizeof(text));
+                res.Printf("%lu,%s\n", (unsigned long)fix.time, text);
+            }
+        }
+    }
+
+
+    inline void HandleGetDevices(Request& req, Response& res)
+    {
+        /*
+            Structure: "id,age,status\nid,age,status\n..."
+            age = ms since the last fix, empty if there was none
+            status = Status::SettingsPending or Status::SettingsApplied
+        */
+
+        req.DiscardRequestBody();
+        res.SetHeader("Content-Type", "text/plain");
+        const uint32_t now = Millis();
+        for (const Device& device : devices)
+        {
+            if (!device.used)
+                continue;
+            const DeviceFix latest = device.fix.Read();
+            if (latest.fixes == 0)
+                res.Printf("%s,,%d\n", device.id, SettingsStatus(device));
+            else
+                res.Printf("%s,%lu,%d\n", device.id, (unsigned long)(now - latest.fix.time), SettingsStatus(device));
+        }
+    }
+
+
+    inline void Handle404(Request& req, Response& res)
+    {
+        res.SetStatusCode(Status::Error);
+        req.DiscardRequestBody();
+    }
+
+
+    // The handlers that only read the seqlocks and the published device slots. A front end runs them outside of its
+    // lock after Authenticate, in parallel to each other and to the handlers that write.
+    inline bool IsLockFree(void (*handler)(Request&, Response&))
+    {
+        return handler == HandleGet || handler == HandleGetTrackerSettingsStatus;
+    }
+} // namespace Minerva
+
+#undef MINERVA_REPORT_ERROR
+#endif // MINERVA_H
@@ -0,0 +1,659 @@
+#ifndef MINERVA_ESP32_H
+#define MINERVA_ESP32_H
+/*
+    The ESP32 front end of Minerva.h on top of esp32_https_server, shared by https_server.ino and https_server_oled.ino.
+    A sketch includes it once, calls Minerva::Begin() and StartServer() from setup() and keeps loop() for itself:
+
+        #define MINERVA_ESP32_STATUS(message) Print(message) // optional, before the include
+        #include "MinervaEsp32.h"
+
+        Minerva::Begin(LOGIN_USER, LOGIN_KEY);
+        StartServer(WIFI_SSID, WIFI_PSK);
+*/
+
+// Called with the progress of StartServer() and before a restart, e.g. to show it on a display
+#ifndef MINERVA_ESP32_STATUS
+#define MINERVA_ESP32_STATUS(message)
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+// Includes for the server
+#include <SSLCert.hpp>
+#include <HTTPSServer.hpp>
+#include <HTTPRequest.hpp>
+#include <HTTPResponse.hpp>
+#include <lwip/sockets.h>
+using namespace httpsserver;
+
+#include "Minerva.h"
+using namespace Minerva;
+
+// Counters for GET /metrics, everything is preallocated so a request only costs a few additions.
+// Latencies are counted per bucket, the upper bounds are in ms and the last bucket has none.
+constexpr unsigned long latencyBoundsMs[] = { 1, 5, 10, 50, 100, 500, 1000, 5000, 20000 };
+constexpr size_t latencyBuckets = sizeof(latencyBoundsMs) / sizeof(latencyBoundsMs[0]) + 1;
+struct Histogram
+{
+    uint32_t buckets[latencyBuckets];
+    uint32_t count;
+    uint64_t sumUs;
+
+    void Add(unsigned long us)
+    {
+        size_t i = 0;
+        while (i < latencyBuckets - 1 && us >= latencyBoundsMs[i] * 1000)
+            ++i;
+        ++buckets[i];
+        ++count;
+        sumUs += us;
+    }
+};
+
+constexpr size_t maxEndpoints = 16;
+struct EndpointMetrics
+{
+    HTTPNode* node; // nullptr = free slot
+    Histogram latency;
+};
+EndpointMetrics endpointMetrics[maxEndpoints] = {};
+
+struct Metrics
+{
+    Histogram handshake;       // createConnection(), which runs the whole TLS handshake
+    uint32_t handshakeFailures; // both written with the mutex of EventServer held
+    volatile uint32_t wifiConnects; // counted in the WiFi event task
+};
+Metrics metrics = {};
+
+
+constexpr unsigned long serverIdleWaitMs = 1000;
+
+// Every connection has a task with an 8 KB stack, and mbedtls takes about 30 KB of heap for its TLS buffers while it's
+// open. 6 leave enough heap for WiFi on a module without PSRAM, the library allows up to 32.
+constexpr uint8_t maxConnections = 6;
+
+// Reads the protected state of an HTTPConnection, a member pointer formed in a derived class may be used on any
+// HTTPConnection. The library parses a request over several loop() calls, one state per call.
+struct ConnectionAccess : HTTPConnection
+{
+    static int State(HTTPConnection* connection) { return connection->*(&ConnectionAccess::_connectionState); }
+    // decrypted bytes the socket doesn't show anymore
+    static bool HasPending(HTTPConnection* connection) { return (connection->*(&ConnectionAccess::pendingByteCount))() > 0; }
+    // kept alive between two requests, nothing of the next one has arrived
+    static bool IsIdle(HTTPConnection* connection)
+    {
+        return State(connection) == STATE_INITIAL && !HasPending(connection)
+            && connection->*(&ConnectionAccess::_bufferProcessed) == connection->*(&ConnectionAccess::_bufferUnusedIdx);
+    }
+};
+
+// HTTPSServer that serves every connection in a task of its own, so any number of them can hold a long-poll
+// request in WaitForChange(). The library finishes a response as soon as the handler returns, a held request
+// needs a stack that stays. Accept() replaces loop() of the library and runs in ServerTask.
+// The tasks take turns on one mutex, the library and the handlers that write never run at the same time. A task
+// lets go of it while it waits for its socket, while it runs a lock-free handler (Minerva::IsLockFree) like GET /
+// and while that one waits in WaitForChange(). Every served step wakes the held requests to check again. The TLS
+// handshake of a new connection runs outside of it as well, in ServerTask.
+// There are far fewer slots than trackers keeping their connection alive. Once all are taken and another client
+// connects, the connection that has been idle the longest is closed for it, its tracker reconnects on its next upload.
+class EventServer : public HTTPSServer
+{
+public:
+    using HTTPSServer::HTTPSServer;
+
+    // one task per connection slot, before the first Accept()
+    void StartConnectionTasks()
+    {
+        for (uint8_t i = 0; i < _maxConnections; ++i)
+        {
+            m_Slots[i].server = this;
+            m_Slots[i].index = i;
+            xTaskCreatePinnedToCore(ConnectionTask, "https-conn", connectionTaskStack, &m_Slots[i], 1, &m_Slots[i].task, ARDUINO_RUNNING_CORE);
+        }
+    }
+
+    // Runs the TLS handshake of a new connection and hands it to the task of its slot. Blocks until the server
+    // socket is readable or a slot is freed, at most timeoutMs.
+    void Accept(unsigned long timeoutMs)
+    {
+        if (!_running)
+            return;
+
+        int freeIdx = -1;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            for (uint8_t i = 0; i < _maxConnections && freeIdx == -1; ++i)
+            {
+                if (_connections[i] == nullptr)
+                    freeIdx = i;
+            }
+            if (freeIdx == -1)
+            {
+                if (IsReadable(_socket, 0))
+                    EvictIdle();
+                m_SlotFreed.wait_for(lock, std::chrono::milliseconds(timeoutMs));
+                return;
+            }
+        }
+
+        if (!IsReadable(_socket, timeoutMs))
+            return;
+
+        // The handshake runs without the mutex, a client that is slow to send its hello only keeps new
+        // connections waiting. createConnection() stores the connection in the free slot right away, a free
+        // slot is only looked at by this task and the task of the slot waits for the notification below.
+        const unsigned long start = micros();
+        const int result = createConnection(freeIdx);
+        const unsigned long us = micros() - start;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        metrics.handshake.Add(us);
+        if (result < 0)
+        {
+            ++metrics.handshakeFailures;
+            delete _connections[freeIdx];
+            _connections[freeIdx] = nullptr;
+            return;
+        }
+        m_Slots[freeIdx].socket = result; // createConnection() returns the accepted socket
+        xTaskNotifyGive(m_Slots[freeIdx].task);
+    }
+
+    // Runs a lock-free handler of the calling connection task without the mutex, the task holds it in Serve()
+    template <typename F>
+    void RunUnlocked(F run)
+    {
+        m_Mutex.unlock();
+        run();
+        m_Mutex.lock();
+    }
+
+    // Called by EspRequest::Hold() from a handler in RunUnlocked() to block until changed() returns true or the
+    // timeout ran out, the other connections are served meanwhile. changed() is checked with the mutex held, the
+    // handlers that write hold it as well, so a change can't slip in between a check and the wait.
+    // One slot is never held, so a tracker upload always finds one. If the request would take it, it's answered
+    // right away, the app asks again once the wait would have run out.
+    bool WaitForChange(const std::function<bool()>& changed, unsigned long timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        bool result;
+        if (m_Holding + 1 >= _maxConnections)
+            result = changed();
+        else
+        {
+            ++m_Holding;
+            const unsigned long start = micros();
+            result = m_Changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), changed);
+            --m_Holding;
+            Slot* slot = CurrentSlot();
+            if (slot != nullptr)
+                slot->heldUs += micros() - start;
+        }
+        return result;
+    }
+
+    // Time the calling connection task waited in WaitForChange() since the last call, Measure() leaves it out
+    // of the latency of the request
+    unsigned long TakeHeldUs()
+    {
+        Slot* slot = CurrentSlot();
+        if (slot == nullptr)
+            return 0;
+        const unsigned long us = slot->heldUs;
+        slot->heldUs = 0;
+        return us;
+    }
+private:
+    using HTTPServer::createConnection; // virtual, ends up in HTTPSServer::createConnection
+
+    struct Slot
+    {
+        EventServer* server;
+        uint8_t index;
+        int socket; // of _connections[index], only valid while it's open
+        TaskHandle_t task;
+        unsigned long heldUs; // see TakeHeldUs()
+        bool idle;            // waits for the next request of its connection
+        unsigned long idleSince;
+        bool evict;           // close the connection if it's still idle once its task wakes up
+    };
+
+    // a handler runs in the task of its connection, with its response and the library on the same stack
+    static constexpr uint32_t connectionTaskStack = 8192;
+
+    static void ConnectionTask(void* arg)
+    {
+        Slot& slot = *static_cast<Slot*>(arg);
+        for (;;)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Accept() put a connection into the slot
+            slot.server->Serve(slot);
+        }
+    }
+
+    // same as HTTPServer::loop() for one connection, until it's closed
+    void Serve(Slot& slot)
+    {
+        HTTPConnection*& connection = _connections[slot.index];
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        bool idle = false;
+        while (!connection->isClosed())
+        {
+            const int state = ConnectionAccess::State(connection);
+            connection->loop();
+            if (ConnectionAccess::State(connection) != state || ConnectionAccess::HasPending(connection))
+            {
+                idle = false;
+                m_Changed.notify_all(); // a request may have changed what is held for
+                continue; // the next state may already be buffered
+            }
+            // only marked idle while it waits for its socket, EvictIdle() runs with the mutex held
+            const bool wasIdle = idle;
+            idle = ConnectionAccess::IsIdle(connection); // not once a part of the next request is buffered
+            if (idle && !wasIdle)
+                slot.idleSince = millis();
+            slot.idle = idle;
+            lock.unlock();
+            IsReadable(slot.socket, serverIdleWaitMs); // loop() also times idle connections out
+            lock.lock();
+            slot.idle = false;
+            if (slot.evict && idle && !IsReadable(slot.socket, 0))
+                connection->closeConnection();
+            slot.evict = false;
+        }
+        delete connection;
+        connection = nullptr;
+        m_SlotFreed.notify_one();
+    }
+
+    // asks the task of the connection that is idle the longest to close it, with the mutex held
+    void EvictIdle()
+    {
+        Slot* oldest = nullptr;
+        for (uint8_t i = 0; i < _maxConnections; ++i)
+        {
+            Slot& slot = m_Slots[i];
+            if (slot.evict)
+                return; // one is already on its way out
+            if (slot.idle && (oldest == nullptr || (long)(slot.idleSince - oldest->idleSince) < 0))
+                oldest = &slot;
+        }
+        if (oldest != nullptr)
+            oldest->evict = true;
+    }
+
+    Slot* CurrentSlot()
+    {
+        const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+        for (uint8_t i = 0; i < _maxConnections; ++i)
+        {
+            if (m_Slots[i].task == task)
+                return &m_Slots[i];
+        }
+        return nullptr;
+    }
+
+    static bool IsReadable(int socket, unsigned long timeoutMs)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(socket, &fds);
+        timeval timeout = { (long)(timeoutMs / 1000), (long)(timeoutMs % 1000) * 1000 };
+        return select(socket + 1, &fds, nullptr, nullptr, &timeout) > 0;
+    }
+private:
+    Slot m_Slots[32] = {}; // the library allows up to 32 connections
+    uint8_t m_Holding = 0; // tasks in WaitForChange()
+    std::mutex m_Mutex;
+    std::condition_variable m_Changed;
+    std::condition_variable m_SlotFreed;
+};
+
+std::unique_ptr<EventServer> secureServer;
+
+// Minerva::Request and Minerva::Response on top of the ones of esp32_https_server
+class EspRequest : public Minerva::Request
+{
+public:
+    EspRequest(HTTPRequest* req, Minerva::Response& res) : m_Req(req), m_Res(res) {}
+
+    std::string GetHeader(const std::string& name) override { return m_Req->getHeader(name); }
+    bool GetQueryParameter(const std::string& name, std::string& value) override { return m_Req->getParams()->getQueryParameter(name, value); }
+    std::string GetBasicAuthUser() override { return m_Req->getBasicAuthUser(); }
+    std::string GetBasicAuthPassword() override { return m_Req->getBasicAuthPassword(); }
+    uint32_t GetClientIP() override { return m_Req->getClientIP(); }
+
+    size_t ReadBytes(uint8_t* buffer, size_t size) override { return m_Req->readBytes(buffer, size); }
+    bool RequestComplete() override { return m_Req->requestComplete(); }
+    void DiscardRequestBody() override { m_Req->discardRequestBody(); }
+
+    // the connection task of the request waits in it, the response goes out once the handler returns
+    void Hold(std::function<bool()> changed, unsigned long timeoutMs, std::function<void(Minerva::Response&)> respond) override
+    {
+        secureServer->WaitForChange(changed, timeoutMs);
+        respond(m_Res);
+    }
+private:
+    HTTPRequest* m_Req;
+    Minerva::Response& m_Res;
+};
+
+class EspResponse : public Minerva::Response
+{
+public:
+    explicit EspResponse(HTTPResponse* res) : m_Res(res) {}
+
+    void SetStatusCode(uint16_t code) override { m_Res->setStatusCode(code); }
+    void SetStatusText(const std::string& text) override { m_Res->setStatusText(text); }
+    void SetHeader(const std::string& name, const std::string& value) override { m_Res->setHeader(name, value); }
+    void Write(const uint8_t* data, size_t size) override { m_Res->write(data, size); }
+private:
+    HTTPResponse* m_Res;
+};
+
+// a Minerva handler as ResourceNode callback: new ResourceNode("/", "GET", &Serve<HandleGet>::Callback)
+template <void (*Handler)(Minerva::Request&, Minerva::Response&)>
+struct Serve
+{
+    static void Callback(HTTPRequest* req, HTTPResponse* res)
+    {
+        EspResponse response(res);
+        EspRequest request(req, response);
+        if (Minerva::IsLockFree(Handler))
+            secureServer->RunUnlocked([&] { Handler(request, response); });
+        else
+            Handler(request, response);
+    }
+};
+
+constexpr const char* certNamespace = "tls"; // NVS namespace of the private key and certificate
+volatile bool restartPending = false;
+
+
+void Restart()
+{
+    MINERVA_ESP32_STATUS("Restarting...");
+    delay(100); // let a display show it
+    ESP.restart();
+}
+
+
+// The private key and the certificate are kept in NVS so they survive a reboot. This saves the seconds the
+// RSA key generation takes and clients keep seeing the same certificate, POST /settings/tls/rotate forces a new one.
+// Be aware that the flash of the ESP32 is not encrypted unless flash encryption is enabled, so anyone with the hardware
+// can extract the key.
+std::unique_ptr<SSLCert> LoadCert()
+{
+    Preferences prefs;
+    if (!prefs.begin(certNamespace, true))
+        return nullptr;
+
+    std::unique_ptr<SSLCert> cert;
+    const size_t pkLength = prefs.getBytesLength("pk");
+    const size_t certLength = prefs.getBytesLength("cert");
+    if (pkLength != 0 && certLength != 0)
+    {
+        // SSLCert only keeps the pointers, so the buffers have to outlive it
+        unsigned char* pkData = new unsigned char[pkLength];
+        unsigned char* certData = new unsigned char[certLength];
+        if (prefs.getBytes("pk", pkData, pkLength) == pkLength && prefs.getBytes("cert", certData, certLength) == certLength)
+        {
+            cert.reset(new SSLCert(certData, certLength, pkData, pkLength));
+        }
+        else
+        {
+            delete[] pkData;
+            delete[] certData;
+        }
+    }
+    prefs.end();
+    return cert;
+}
+
+
+void StoreCert(SSLCert& cert)
+{
+    Preferences prefs;
+    if (!prefs.begin(certNamespace, false))
+        return;
+    prefs.putBytes("pk", cert.getPKData(), cert.getPKLength());
+    prefs.putBytes("cert", cert.getCertData(), cert.getCertLength());
+    prefs.end();
+}
+
+
+std::unique_ptr<SSLCert> CreateCert()
+{
+    std::unique_ptr<SSLCert> cert(new SSLCert());
+
+    // Key size: 1024 or 2048 bit should be fine here, 4096 on the ESP might be "paranoid mode"
+    // Distinguished name: The part after CN (Common Name) should match the DNS entry pointing to the ESP32
+    // Dates for certificate validity, format is YYYYMMDDhhmmss
+    int createCertResult = createSelfSignedCert(
+        *cert,
+        KEYSIZE_1024,
+        "CN=myesp32.local,O=pyvyx,C=DE",
+        "20190101000000",
+        "20300101000000");
+
+    if (createCertResult != 0)
+        return nullptr;
+    return cert;
+}
+
+
+void OnWiFiConnected(WiFiEvent_t, WiFiEventInfo_t)
+{
+    metrics.wifiConnects = metrics.wifiConnects + 1; // no compound assignment, C++20 deprecates it on volatile
+}
+
+
+void ServerTask(void*)
+{
+    for (;;)
+    {
+        secureServer->Accept(serverIdleWaitMs);
+        if (restartPending)
+        {
+            delay(500); // let the client receive the response
+            Restart();
+        }
+    }
+}
+
+
+void AuthenticateMiddleware(HTTPRequest* req, HTTPResponse* res, std::function<void()> next)
+{
+    EspResponse response(res);
+    EspRequest request(req, response);
+    Minerva::Authenticate(request, response, next);
+}
+
+
+EndpointMetrics* FindEndpointMetrics(HTTPNode* node)
+{
+    for (EndpointMetrics& e : endpointMetrics)
+    {
+        if (e.node == node)
+            return &e;
+        if (e.node == nullptr)
+        {
+            e.node = node; // first request to this node
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+
+void Measure(HTTPRequest* req, HTTPResponse* res, std::function<void()> next)
+{
+    const unsigned long start = micros();
+    next();
+    const unsigned long held = secureServer->TakeHeldUs(); // a long-poll waits for a change, not for the server
+    HTTPNode* node = req->getResolvedNode();
+    EndpointMetrics* e = node == nullptr ? nullptr : FindEndpointMetrics(node);
+    if (e != nullptr)
+        e->latency.Add(micros() - start - held);
+}
+
+
+void HandlePostRotateCert(HTTPRequest* req, HTTPResponse* res)
+{
+    // drop the stored certificate, a new one is created on the next boot
+    req->discardRequestBody();
+    Preferences prefs;
+    if (!prefs.begin(certNamespace, false) || !prefs.clear())
+    {
+        res->setStatusCode(Status::Error);
+        return;
+    }
+    prefs.end();
+    res->setHeader("Connection", "close");
+    restartPending = true;
+}
+
+
+// labels is either empty or like 'endpoint="GET /"'
+void PrintHistogram(HTTPResponse* res, const char* name, const std::string& labels, const Histogram& histogram)
+{
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    const std::string braced = labels.empty() ? "" : "{" + labels + "}";
+
+    // prometheus buckets are cumulative
+    uint32_t count = 0;
+    for (size_t i = 0; i < latencyBuckets - 1; ++i)
+    {
+        count += histogram.buckets[i];
+        res->printf("%s_bucket{%sle=\"%lu\"} %u\n", name, prefix.c_str(), latencyBoundsMs[i], (unsigned)count);
+    }
+    res->printf("%s_bucket{%sle=\"+Inf\"} %u\n", name, prefix.c_str(), (unsigned)histogram.count);
+    res->printf("%s_sum%s %.3f\n", name, braced.c_str(), histogram.sumUs / 1000.0);
+    res->printf("%s_count%s %u\n", name, braced.c_str(), (unsigned)histogram.count);
+}
+
+
+void HandleGetMetrics(HTTPRequest* req, HTTPResponse* res)
+{
+    /*
+        Structure: prometheus text format, latencies are in ms
+        minerva_request_ms is per endpoint, "method path" or "404" for requests that hit Handle404, without the
+        time a long-poll was held
+    */
+
+    req->discardRequestBody();
+    res->setHeader("Content-Type", "text/plain; version=0.0.4");
+    res->printf("minerva_uptime_ms %lu\n", millis());
+    res->printf("minerva_heap_free_bytes %u\n", (unsigned)ESP.getFreeHeap());
+    res->printf("minerva_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+    res->printf("minerva_heap_max_alloc_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+    res->printf("minerva_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+    const uint32_t connects = metrics.wifiConnects;
+    res->printf("minerva_wifi_reconnects_total %u\n", (unsigned)(connects == 0 ? 0 : connects - 1));
+    res->printf("minerva_auth_failures_total %u\n", (unsigned)counters.authFailures);
+    res->printf("minerva_penalized_requests_total %u\n", (unsigned)counters.penalized);
+    res->printf("minerva_expired_sessions_total %u\n", (unsigned)counters.expiredSessions);
+    res->printf("minerva_tls_handshake_failures_total %u\n", (unsigned)metrics.handshakeFailures);
+    PrintHistogram(res, "minerva_tls_handshake_ms", "", metrics.handshake);
+
+    for (const EndpointMetrics& e : endpointMetrics)
+    {
+        if (e.node == nullptr)
+            break;
+        const std::string endpoint = e.node->_path.empty() ? "404" : e.node->getMethod() + " " + e.node->_path;
+        PrintHistogram(res, "minerva_request_ms", "endpoint=\"" + endpoint + "\"", e.latency);
+    }
+}
+
+
+// Loads the certificate or creates one, connects to WiFi, registers the handlers and starts serving
+// from ServerTask. Restarts the ESP32 if there is no certificate or the server doesn't start.
+void StartServer(const char* ssid, const char* psk)
+{
+    std::unique_ptr<SSLCert> cert = LoadCert();
+    if (!cert)
+    {
+        MINERVA_ESP32_STATUS("Creating self-signed certificate");
+        cert = CreateCert();
+        if (!cert)
+        {
+            MINERVA_ESP32_STATUS("Failed to create certificate");
+            Restart();
+        }
+        StoreCert(*cert);
+        MINERVA_ESP32_STATUS("Successfully created certificate");
+    }
+    else
+    {
+        MINERVA_ESP32_STATUS("Loaded certificate");
+    }
+
+    // the server keeps using the certificate, it lives as long as the ESP32 runs
+    secureServer = std::unique_ptr<EventServer>(new EventServer(cert.release(), 443, maxConnections));
+
+    // Connect to WiFi
+    WiFi.onEvent(OnWiFiConnected, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.begin(ssid, psk);
+    for (size_t dots = 0; WiFi.status() != WL_CONNECTED; dots = (dots + 1) % 4)
+    {
+        MINERVA_ESP32_STATUS((std::string("Setting up WiFi") + std::string(dots, '.')).c_str());
+        delay(500);
+    }
+    MINERVA_ESP32_STATUS("Connected");
+
+    // For every resource available on the server, we need to create a ResourceNode
+    // The ResourceNode links URL and HTTP method to a handler function
+    ResourceNode* nodeGet = new ResourceNode("/", "GET", &Serve<HandleGet>::Callback);
+    ResourceNode* node404 = new ResourceNode("", "GET", &Serve<Handle404>::Callback);
+    ResourceNode* nodePost = new ResourceNode("/", "POST", &Serve<HandlePost>::Callback);
+    ResourceNode* nodePostBatch = new ResourceNode("/batch", "POST", &Serve<HandlePostBatch>::Callback);
+    ResourceNode* nodeGetHistory = new ResourceNode("/history", "GET", &Serve<HandleGetHistory>::Callback);
+    ResourceNode* nodeGetDevices = new ResourceNode("/devices", "GET", &Serve<HandleGetDevices>::Callback);
+    ResourceNode* nodeGetTrackerSettingsStatus = new ResourceNode("/settings/tracker/status", "GET", &Serve<HandleGetTrackerSettingsStatus>::Callback);
+    ResourceNode* nodePostTrackerSettingsApplied = new ResourceNode("/settings/tracker/applied", "GET", &Serve<HandleGetTrackerSettingsApplied>::Callback);
+    ResourceNode* nodeGetTrackerSettings = new ResourceNode("/settings/tracker", "GET", &Serve<HandleGetTrackerSettings>::Callback);
+    ResourceNode* nodePostTrackerSettings = new ResourceNode("/settings/tracker", "POST", &Serve<HandlePostTrackerSettings>::Callback);
+    ResourceNode* nodePostLogin = new ResourceNode("/login", "POST", &Serve<HandlePostLogin>::Callback);
+    ResourceNode* nodePostRotateCert = new ResourceNode("/settings/tls/rotate", "POST", &HandlePostRotateCert);
+    ResourceNode* nodeGetMetrics = new ResourceNode("/metrics", "GET", &HandleGetMetrics);
+
+    secureServer->registerNode(nodeGet);
+    secureServer->registerNode(nodePost);
+    secureServer->registerNode(nodePostBatch);
+    secureServer->registerNode(nodeGetHistory);
+    secureServer->registerNode(nodeGetDevices);
+    secureServer->registerNode(nodeGetTrackerSettingsStatus);
+    secureServer->registerNode(nodePostTrackerSettingsApplied);
+    secureServer->registerNode(nodeGetTrackerSettings);
+    secureServer->registerNode(nodePostTrackerSettings);
+    secureServer->registerNode(nodePostLogin);
+    secureServer->registerNode(nodePostRotateCert);
+    secureServer->registerNode(nodeGetMetrics);
+    secureServer->setDefaultNode(node404);
+    secureServer->addMiddleware(Measure); // first so rejected requests are measured too
+    secureServer->addMiddleware(AuthenticateMiddleware);
+
+    MINERVA_ESP32_STATUS("Starting server...");
+    secureServer->start();
+    if (!secureServer->isRunning())
+    {
+        MINERVA_ESP32_STATUS("Failed to start server...Attempting restart");
+        Restart();
+    }
+    MINERVA_ESP32_STATUS("Server ready");
+
+    // the TLS handshake needs a large stack
+    secureServer->StartConnectionTasks();
+    xTaskCreatePinnedToCore(ServerTask, "https", 12288, nullptr, 1, nullptr, ARDUINO_RUNNING_CORE);
+}
+
+#undef MINERVA_ESP32_STATUS
+#endif // MINERVA_ESP32_H
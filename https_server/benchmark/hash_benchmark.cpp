@@ -0,0 +1,156 @@
+// Throughput of every algorithm in Hash.h through the C and the C++ interface, one csv line per interface, algorithm and message size
+//
+//     g++ -O2 -std=c++17 -pthread hash_benchmark.cpp -o hash_benchmark
+//     ./hash_benchmark [max bytes, default 1073741824] [seconds per measurement, default 0.25] > results.csv
+//
+// bytes is the message size and MB is 10^6 bytes, cycles_per_byte is only measured on x86 (time stamp counter) and empty elsewhere
+#define HASH_ENABLE_MD5    1
+#define HASH_ENABLE_SHA1   1
+#define HASH_ENABLE_SHA2   1
+#define HASH_ENABLE_KECCAK 1
+#define HASH_ENABLE_C_INTERFACE   1
+#define HASH_ENABLE_CPP_INTERFACE 1
+#include "../Hash.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HASH_BENCHMARK_CYCLES 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HASH_BENCHMARK_CYCLES 1
+#else
+#define HASH_BENCHMARK_CYCLES 0
+#endif
+
+volatile uint8_t sink = 0; // keeps the compiler from dropping the hashes
+
+inline void Sink(const uint8_t* digest, std::size_t size)
+{
+    uint8_t x = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        x ^= digest[i];
+    sink = sink ^ x;
+}
+
+inline uint64_t Cycles()
+{
+#if HASH_BENCHMARK_CYCLES == 1
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+
+struct Algorithm
+{
+    const char* interface;
+    const char* name;
+    void (*hash)(const uint8_t* data, std::size_t size);
+};
+
+// every hash goes through init, update, finalize and the raw digest so no formatting is measured
+#define HASH_BENCHMARK_C(name, type, init, prefix, digestSize) \
+    { "c", name, [](const uint8_t* data, std::size_t size) { type s; init; prefix##_update_binary(s, (const char*)data, size); prefix##_finalize(s); uint8_t digest[64]; prefix##_digest(s, digest); Sink(digest, digestSize); } }
+#define HASH_BENCHMARK_CPP(name, type, digestSize) \
+    { "cpp", name, [](const uint8_t* data, std::size_t size) { type h; h.Update(data, size); h.Finalize(); uint8_t digest[64]; h.Digest(digest); Sink(digest, digestSize); } }
+
+static const Algorithm algorithms[] =
+{
+    HASH_BENCHMARK_C("sha224", Hash_Sha224, hash_sha224_init(s), hash_sha224, 28),
+    HASH_BENCHMARK_C("sha256", Hash_Sha256, hash_sha256_init(s), hash_sha256, 32),
+    HASH_BENCHMARK_C("sha384", Hash_Sha384, hash_sha384_init(s), hash_sha384, 48),
+    HASH_BENCHMARK_C("sha512", Hash_Sha512, hash_sha512_init(s), hash_sha512, 64),
+    HASH_BENCHMARK_C("sha512/224", Hash_Sha512T, hash_sha512t_init(s, 224), hash_sha512t, 28),
+    HASH_BENCHMARK_C("sha512/256", Hash_Sha512T, hash_sha512t_init(s, 256), hash_sha512t, 32),
+    HASH_BENCHMARK_C("sha1", Hash_Sha1, hash_sha1_init(s), hash_sha1, 20),
+    HASH_BENCHMARK_C("md5", Hash_MD5, hash_md5_init(s), hash_md5, 16),
+    HASH_BENCHMARK_C("sha3-224", Hash_Sha3, hash_sha3_224_init(s), hash_sha3, 28),
+    HASH_BENCHMARK_C("sha3-256", Hash_Sha3, hash_sha3_256_init(s), hash_sha3, 32),
+    HASH_BENCHMARK_C("sha3-384", Hash_Sha3, hash_sha3_384_init(s), hash_sha3, 48),
+    HASH_BENCHMARK_C("sha3-512", Hash_Sha3, hash_sha3_512_init(s), hash_sha3, 64),
+    { "c", "shake128", [](const uint8_t* data, std::size_t size) { Hash_Shake s; hash_shake128_init(s); hash_shake_update_binary(s, (const char*)data, size); hash_shake_finalize(s); uint8_t out[32]; hash_shake_squeeze(s, out, 32); Sink(out, 32); } },
+    { "c", "shake256", [](const uint8_t* data, std::size_t size) { Hash_Shake s; hash_shake256_init(s); hash_shake_update_binary(s, (const char*)data, size); hash_shake_finalize(s); uint8_t out[64]; hash_shake_squeeze(s, out, 64); Sink(out, 64); } },
+
+    HASH_BENCHMARK_CPP("sha224", Hash::Sha224, 28),
+    HASH_BENCHMARK_CPP("sha256", Hash::Sha256, 32),
+    HASH_BENCHMARK_CPP("sha384", Hash::Sha384, 48),
+    HASH_BENCHMARK_CPP("sha512", Hash::Sha512, 64),
+    HASH_BENCHMARK_CPP("sha512/224", Hash::Sha512_224, 28),
+    HASH_BENCHMARK_CPP("sha512/256", Hash::Sha512_256, 32),
+    HASH_BENCHMARK_CPP("sha1", Hash::Sha1, 20),
+    // the MD5 class has no raw digest, so its number includes the hex formatting
+    { "cpp", "md5", [](const uint8_t* data, std::size_t size) { Hash::MD5 h; h.update(data, (Hash::MD5::size_type)size); h.finalize(); sink = sink ^ (uint8_t)h.hexdigest()[0]; } },
+    { "cpp", "sha3-224", [](const uint8_t* data, std::size_t size) { Hash::Sha3 h(224); h.Update(data, size); h.Finalize(); uint8_t digest[28]; h.Digest(digest); Sink(digest, 28); } },
+    { "cpp", "sha3-256", [](const uint8_t* data, std::size_t size) { Hash::Sha3 h(256); h.Update(data, size); h.Finalize(); uint8_t digest[32]; h.Digest(digest); Sink(digest, 32); } },
+    { "cpp", "sha3-384", [](const uint8_t* data, std::size_t size) { Hash::Sha3 h(384); h.Update(data, size); h.Finalize(); uint8_t digest[48]; h.Digest(digest); Sink(digest, 48); } },
+    { "cpp", "sha3-512", [](const uint8_t* data, std::size_t size) { Hash::Sha3 h(512); h.Update(data, size); h.Finalize(); uint8_t digest[64]; h.Digest(digest); Sink(digest, 64); } },
+    { "cpp", "shake128", [](const uint8_t* data, std::size_t size) { Hash::Shake h(128); h.Update(data, size); h.Finalize(); uint8_t out[32]; h.Squeeze(out, 32); Sink(out, 32); } },
+    { "cpp", "shake256", [](const uint8_t* data, std::size_t size) { Hash::Shake h(256); h.Update(data, size); h.Finalize(); uint8_t out[64]; h.Squeeze(out, 64); Sink(out, 64); } },
+};
+#undef HASH_BENCHMARK_C
+#undef HASH_BENCHMARK_CPP
+
+
+struct Result
+{
+    uint64_t iterations;
+    double seconds;
+    uint64_t cycles;
+};
+
+// doubles the iterations until one run takes at least minSeconds
+Result Measure(const Algorithm& algorithm, const uint8_t* data, std::size_t size, double minSeconds)
+{
+    algorithm.hash(data, size); // warm up caches and the cpu feature detection
+    for (uint64_t iterations = 1;; iterations *= 2)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = Cycles();
+        for (uint64_t i = 0; i < iterations; ++i)
+            algorithm.hash(data, size);
+        const uint64_t cycles = Cycles() - startCycles;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= minSeconds)
+            return { iterations, seconds, cycles };
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    const std::size_t maxSize = argc > 1 ? (std::size_t)std::strtoull(argv[1], nullptr, 10) : (std::size_t)1 << 30;
+    const double minSeconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.25;
+
+    std::vector<uint8_t> data(maxSize);
+    uint64_t x = 0x9e3779b97f4a7c15; // xorshift, the content doesn't matter but shouldn't be all zeros
+    for (uint8_t& byte : data)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        byte = (uint8_t)x;
+    }
+
+    std::printf("interface,algorithm,bytes,iterations,ns_per_hash,mb_per_s,cycles_per_byte\n");
+    for (const Algorithm& algorithm : algorithms)
+    {
+        for (std::size_t size = 16; size <= maxSize; size *= 4)
+        {
+            const Result r = Measure(algorithm, data.data(), size, minSeconds);
+            const double bytes = (double)size * (double)r.iterations;
+            std::printf("%s,%s,%zu,%llu,%.1f,%.2f,", algorithm.interface, algorithm.name, size, (unsigned long long)r.iterations, r.seconds * 1e9 / (double)r.iterations, bytes / r.seconds / 1e6);
+            if (HASH_BENCHMARK_CYCLES == 1)
+                std::printf("%.2f", (double)r.cycles / bytes);
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,469 @@
+// Load generator for the Minerva servers. It simulates a fleet of trackers uploading fixes and app clients
+// polling like main.dart, then prints throughput, latency percentiles, TLS handshake cost and errors per request type.
+//
+//	go run loadgen.go -url https://192.168.178.90 -trackers 20 -apps 5 -duration 2m
+//	go run loadgen.go -url https://localhost:8443 -trackers 500 -interval 5s -batch 10 -keepalive=false
+//
+// Every simulated tracker and app has its own connection like the real ones and starts at a random point of its interval
+// so the load is spread instead of arriving in waves. A request counts as an error when the transport fails or the status
+// isn't one the server answers on success (204 is Status::Error of the sketch), the reason is listed below the table.
+// With -ids every tracker is its own device, past the device limit of the server (48) every upload gets a 204.
+//
+// Trackers: POST / (or POST /batch with -batch > 1) every -interval, on 201 they fetch the settings and mark them applied.
+// Apps: GET / with If-None-Match every -poll, every -settings they post tracker settings and long-poll
+// /settings/tracker/status until the tracker applied them, "applied" is the time the settings took to arrive.
+// Attackers: wrong passwords back to back, their latency shows the penalty of the server.
+// With -login every tracker and app trades the password for a session token with POST /login once and sends it as
+// bearer token, like the app and the tracker do, and logs in again when the server answers 401. Without it every request
+// sends the password and the server hashes it, compare both to see what the sessions save.
+package main
+
+import (
+	"crypto/tls"
+	"errors"
+	"flag"
+	"fmt"
+	"io"
+	"math"
+	"math/rand"
+	"net"
+	"net/http"
+	"net/http/httptrace"
+	"os"
+	"sort"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	StatusSettingsChanged = 201
+	StatusSettingsPending = 202
+	StatusSettingsApplied = 203
+	StatusError           = 204
+	StatusSessionExpired  = 401
+)
+
+var (
+	serverUrl = flag.String("url", "https://localhost", "server to load")
+	user      = flag.String("user", "login", "basic auth user")
+	password  = flag.String("password", "1234", "basic auth password")
+	duration  = flag.Duration("duration", time.Minute, "length of the test")
+	keepAlive = flag.Bool("keepalive", true, "reuse connections, false does a TLS handshake per request")
+	timeout   = flag.Duration("timeout", 30*time.Second, "per request, the long-polls are held up to 20 s")
+	ids       = flag.Bool("ids", true, "every tracker uploads with its own ?id= and every app watches one of them, false shares the default tracker")
+	login     = flag.Bool("login", false, "log in with POST /login and send the session token instead of the password")
+
+	trackers = flag.Int("trackers", 10, "simulated trackers")
+	interval = flag.Duration("interval", 45*time.Second, "time between two uploads of a tracker, sleepAfterSend of the app")
+	batch    = flag.Int("batch", 1, "fixes per upload, more than 1 uses POST /batch")
+
+	apps     = flag.Int("apps", 2, "simulated app clients")
+	poll     = flag.Duration("poll", 45*time.Second, "time between two GET / of an app, serverRequest of the app")
+	settings = flag.Duration("settings", 5*time.Minute, "time between two settings changes of an app, 0 never changes them")
+
+	attackers  = flag.Int("attackers", 0, "clients sending wrong passwords back to back")
+	attackFrom = flag.String("attackfrom", "", "local address of the attackers, the server penalizes per ip so on one machine use e.g. 127.0.0.2 against localhost")
+)
+
+// Op collects the results of one request type
+type Op struct {
+	name      string
+	mutex     sync.Mutex
+	latencies []time.Duration
+	errors    map[string]int
+}
+
+func (op *Op) Add(latency time.Duration) {
+	op.mutex.Lock()
+	op.latencies = append(op.latencies, latency)
+	op.mutex.Unlock()
+}
+
+func (op *Op) Error(reason string) {
+	op.mutex.Lock()
+	op.errors[reason]++
+	op.mutex.Unlock()
+}
+
+var (
+	postOp      = &Op{name: "post", errors: map[string]int{}}
+	batchOp     = &Op{name: "batch", errors: map[string]int{}}
+	fetchOp     = &Op{name: "settings", errors: map[string]int{}}
+	getOp       = &Op{name: "get", errors: map[string]int{}}
+	changeOp    = &Op{name: "change", errors: map[string]int{}}
+	pollOp      = &Op{name: "status", errors: map[string]int{}}
+	statusOp    = &Op{name: "applied", errors: map[string]int{}}
+	attackOp    = &Op{name: "attack", errors: map[string]int{}}
+	loginOp     = &Op{name: "login", errors: map[string]int{}}
+	handshakeOp = &Op{name: "tls handshake", errors: map[string]int{}}
+	ops         = []*Op{postOp, batchOp, fetchOp, getOp, changeOp, pollOp, statusOp, attackOp, loginOp}
+	newConns    atomic.Int64
+	reusedConns atomic.Int64
+	notModified atomic.Int64
+	stop        = make(chan struct{})
+)
+
+// Reason shortens a transport error to something that can be counted, the messages contain addresses and ports
+func Reason(err error) string {
+	var netErr net.Error
+	if errors.As(err, &netErr) && netErr.Timeout() {
+		return "timeout"
+	}
+	text := err.Error()
+	for _, known := range []string{"connection refused", "connection reset", "broken pipe", "EOF", "certificate", "no route"} {
+		if strings.Contains(text, known) {
+			return known
+		}
+	}
+	if i := strings.LastIndex(text, ": "); i >= 0 {
+		return text[i+2:]
+	}
+	return text
+}
+
+// Client is one simulated device with its own connection
+type Client struct {
+	http  *http.Client
+	id    string
+	etag  string
+	token string // of POST /login, "" while there is none
+}
+
+func NewClient(id string, local string) *Client {
+	dialer := &net.Dialer{Timeout: *timeout}
+	if local != "" {
+		dialer.LocalAddr = &net.TCPAddr{IP: net.ParseIP(local)}
+	}
+	transport := &http.Transport{
+		DialContext:         dialer.DialContext,
+		TLSClientConfig:     &tls.Config{InsecureSkipVerify: true}, // the servers use self-signed certificates
+		DisableKeepAlives:   !*keepAlive,
+		MaxIdleConnsPerHost: 1,
+		TLSNextProto:        map[string]func(string, *tls.Conn) http.RoundTripper{}, // HTTP/1.1 like the device
+	}
+	return &Client{http: &http.Client{Transport: transport, Timeout: *timeout}, id: id}
+}
+
+// Do sends one request and records it under op if the status is one of ok, returns the status or 0 if it failed.
+// With -login the right password is replaced by the session token, an expired one is renewed and the request sent again.
+func (c *Client) Do(op *Op, method string, path string, body string, pw string, ok ...int) (int, http.Header) {
+	if !*login || pw != *password {
+		status, header, _ := c.Send(op, method, path, body, func(req *http.Request) { req.SetBasicAuth(*user, pw) }, ok...)
+		return status, header
+	}
+	for attempt := 0; ; attempt++ {
+		if c.token == "" && !c.Login() {
+			op.Error("no session")
+			return 0, nil
+		}
+		status, header, _ := c.Send(op, method, path, body, func(req *http.Request) { req.Header.Set("Authorization", "Bearer "+c.token) }, append(ok, StatusSessionExpired)...)
+		if status != StatusSessionExpired {
+			return status, header
+		}
+		c.token = ""
+		if attempt == 1 {
+			op.Error("session expired")
+			return status, header
+		}
+	}
+}
+
+// Login trades the password for a session token, false if the server didn't hand one out
+func (c *Client) Login() bool {
+	// "token,lifetime_ms"
+	status, _, body := c.Send(loginOp, "POST", "/login", "", func(req *http.Request) { req.SetBasicAuth(*user, *password) }, http.StatusOK)
+	if i := strings.IndexByte(body, ','); status == http.StatusOK && i == 32 {
+		c.token = body[:i]
+	}
+	return c.token != ""
+}
+
+// Send sends one request with the authorization set by auth and records it under op if the status is one of ok,
+// returns the status or 0 if it failed with the header and the body
+func (c *Client) Send(op *Op, method string, path string, body string, auth func(*http.Request), ok ...int) (int, http.Header, string) {
+	url := *serverUrl + path
+	if c.id != "" {
+		if strings.Contains(path, "?") {
+			url += "&id=" + c.id
+		} else {
+			url += "?id=" + c.id
+		}
+	}
+	req, err := http.NewRequest(method, url, strings.NewReader(body))
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	auth(req)
+	if c.etag != "" && op == getOp {
+		req.Header.Set("If-None-Match", c.etag)
+	}
+
+	var handshakeStart time.Time
+	trace := &httptrace.ClientTrace{
+		TLSHandshakeStart: func() { handshakeStart = time.Now() },
+		TLSHandshakeDone: func(_ tls.ConnectionState, err error) {
+			if err != nil {
+				handshakeOp.Error(Reason(err))
+			} else {
+				handshakeOp.Add(time.Since(handshakeStart))
+			}
+		},
+		GotConn: func(info httptrace.GotConnInfo) {
+			if info.Reused {
+				reusedConns.Add(1)
+			} else {
+				newConns.Add(1)
+			}
+		},
+	}
+	req = req.WithContext(httptrace.WithClientTrace(req.Context(), trace))
+
+	start := time.Now()
+	res, err := c.http.Do(req)
+	if err != nil {
+		op.Error(Reason(err))
+		return 0, nil, ""
+	}
+	var received strings.Builder
+	_, err = io.Copy(&received, res.Body)
+	res.Body.Close()
+	latency := time.Since(start)
+	if err != nil {
+		op.Error(Reason(err))
+		return 0, nil, ""
+	}
+
+	for _, code := range ok {
+		if res.StatusCode == code {
+			// an expired session is sent again by Do, only the request that went through counts
+			if res.StatusCode != StatusSessionExpired {
+				op.Add(latency)
+			}
+			return res.StatusCode, res.Header, received.String()
+		}
+	}
+	op.Error(fmt.Sprintf("status %d", res.StatusCode))
+	return res.StatusCode, res.Header, received.String()
+}
+
+// Sleep waits d or until the test is over, false if it's over
+func Sleep(d time.Duration) bool {
+	select {
+	case <-stop:
+		return false
+	case <-time.After(d):
+		return true
+	}
+}
+
+func Id(prefix string, i int, n int) string {
+	if !*ids || n == 0 {
+		return ""
+	}
+	return fmt.Sprintf("%s%d", prefix, i%n)
+}
+
+func RunTracker(i int) {
+	c := NewClient(Id("t", i, *trackers), "")
+	// a random walk around Ingolstadt
+	lat := 48.76 + rand.Float64()*0.1
+	lng := 11.42 + rand.Float64()*0.1
+	if !Sleep(time.Duration(rand.Int63n(int64(*interval)))) {
+		return
+	}
+
+	for {
+		var status int
+		if *batch > 1 {
+			var body strings.Builder
+			for j := *batch - 1; j >= 0; j-- {
+				lat += (rand.Float64() - 0.5) * 0.0002
+				lng += (rand.Float64() - 0.5) * 0.0002
+				fmt.Fprintf(&body, "%d,%.6f,%.6f,%d,%d\n", j*1000, lat, lng, 370+rand.Intn(20), rand.Intn(50))
+			}
+			status, _ = c.Do(batchOp, "POST", "/batch", body.String(), *password, http.StatusOK, StatusSettingsChanged)
+		} else {
+			lat += (rand.Float64() - 0.5) * 0.0002
+			lng += (rand.Float64() - 0.5) * 0.0002
+			body := fmt.Sprintf("%.6f,%.6f,%d,%d", lat, lng, 370+rand.Intn(20), rand.Intn(50))
+			status, _ = c.Do(postOp, "POST", "/", body, *password, http.StatusOK, StatusSettingsChanged)
+		}
+
+		if status == StatusSettingsChanged {
+			if s, _ := c.Do(fetchOp, "GET", "/settings/tracker", "", *password, http.StatusOK); s == http.StatusOK {
+				c.Do(fetchOp, "GET", "/settings/tracker/applied", "", *password, http.StatusOK)
+			}
+		}
+		if !Sleep(*interval) {
+			return
+		}
+	}
+}
+
+func RunApp(i int) {
+	c := NewClient(Id("t", i, *trackers), "")
+	// the long-poll gets a connection and a session of its own once, like the shared client of the app
+	poller := NewClient(c.id, "")
+	var waiting atomic.Bool
+	if !Sleep(time.Duration(rand.Int63n(int64(*poll)))) {
+		return
+	}
+
+	var lastChange time.Time
+	for {
+		status, header := c.Do(getOp, "GET", "/", "", *password, http.StatusOK, http.StatusNotModified)
+		if status == http.StatusNotModified {
+			notModified.Add(1)
+		}
+		if header != nil && header.Get("ETag") != "" {
+			c.etag = header.Get("ETag")
+		}
+
+		if *settings > 0 && time.Since(lastChange) >= *settings {
+			lastChange = time.Now()
+			body := fmt.Sprintf("%d,1000,10,3000", interval.Milliseconds())
+			// the settings page keeps its long-poll running until the tracker applied the newest ones
+			if s, _ := c.Do(changeOp, "POST", "/settings/tracker", body, *password, http.StatusOK); s == http.StatusOK && waiting.CompareAndSwap(false, true) {
+				go func() {
+					WaitForApplied(poller)
+					waiting.Store(false)
+				}()
+			}
+		}
+		if !Sleep(*poll) {
+			return
+		}
+	}
+}
+
+// WaitForApplied is _MakeRequest of the settings page, it runs next to the GET / of the same app on the client
+// RunApp keeps for it, one at a time
+func WaitForApplied(c *Client) {
+	const wait = 20 * time.Second
+	start := time.Now()
+	for {
+		select {
+		case <-stop:
+			return
+		default:
+		}
+		// every round of the long-poll is a status request, the whole wait until the tracker applied them is one applied
+		held := time.Now()
+		res, _ := c.Do(pollOp, "GET", fmt.Sprintf("/settings/tracker/status?wait=%d&status=202", wait.Milliseconds()), "", *password, StatusSettingsPending, StatusSettingsApplied)
+		if res == StatusSettingsApplied {
+			statusOp.Add(time.Since(start))
+			return
+		}
+		if res == 0 {
+			statusOp.Error("transport")
+		} else if res != StatusSettingsPending {
+			statusOp.Error(fmt.Sprintf("status %d", res))
+		}
+		if res != StatusSettingsPending {
+			if !Sleep(60 * time.Second) {
+				return
+			}
+		} else if time.Since(held) < wait/2 {
+			// the server didn't hold it, e.g. the ESP32 with its last connection, ask again once it would have answered
+			if !Sleep(wait - time.Since(held)) {
+				return
+			}
+		}
+	}
+}
+
+func RunAttacker() {
+	c := NewClient("", *attackFrom)
+	for {
+		select {
+		case <-stop:
+			return
+		default:
+		}
+		if s, _ := c.Do(attackOp, "GET", "/", "", "wrong password", StatusError); s == 0 && !Sleep(time.Second) {
+			return
+		}
+	}
+}
+
+func Percentile(sorted []time.Duration, p float64) float64 {
+	if len(sorted) == 0 {
+		return math.NaN()
+	}
+	i := int(math.Ceil(p*float64(len(sorted)))) - 1
+	if i < 0 {
+		i = 0
+	}
+	return float64(sorted[i]) / float64(time.Millisecond)
+}
+
+func PrintOp(op *Op, seconds float64) {
+	op.mutex.Lock()
+	defer op.mutex.Unlock()
+	failed := 0
+	for _, count := range op.errors {
+		failed += count
+	}
+	if len(op.latencies)+failed == 0 {
+		return
+	}
+	sort.Slice(op.latencies, func(a, b int) bool { return op.latencies[a] < op.latencies[b] })
+	n := len(op.latencies)
+	fmt.Printf("%-14s %9d %9.1f %7d %6.2f%% %9.1f %9.1f %9.1f %9.1f\n", op.name, n, float64(n)/seconds, failed,
+		100*float64(failed)/float64(n+failed), Percentile(op.latencies, 0.5), Percentile(op.latencies, 0.99), Percentile(op.latencies, 0.999), Percentile(op.latencies, 1))
+}
+
+func main() {
+	flag.Parse()
+	*serverUrl = strings.TrimSuffix(*serverUrl, "/")
+	fmt.Printf("%d trackers every %v (%d fixes per upload), %d apps every %v, %d attackers, keep-alive %v, %v against %s\n",
+		*trackers, *interval, *batch, *apps, *poll, *attackers, *keepAlive, *duration, *serverUrl)
+
+	var wg sync.WaitGroup
+	run := func(f func()) {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			f()
+		}()
+	}
+	for i := 0; i < *trackers; i++ {
+		i := i
+		run(func() { RunTracker(i) })
+	}
+	for i := 0; i < *apps; i++ {
+		i := i
+		run(func() { RunApp(i) })
+	}
+	for i := 0; i < *attackers; i++ {
+		run(RunAttacker)
+	}
+
+	start := time.Now()
+	time.Sleep(*duration)
+	close(stop)
+	seconds := time.Since(start).Seconds()
+	// requests still in flight may take up to -timeout, they aren't waited for
+	done := make(chan struct{})
+	go func() { wg.Wait(); close(done) }()
+	select {
+	case <-done:
+	case <-time.After(time.Second):
+	}
+
+	fmt.Printf("\n%-14s %9s %9s %7s %7s %9s %9s %9s %9s\n", "", "ok", "per s", "errors", "", "p50 ms", "p99 ms", "p999 ms", "max ms")
+	for _, op := range ops {
+		PrintOp(op, seconds)
+	}
+	PrintOp(handshakeOp, seconds)
+	fmt.Printf("\nconnections: %d new, %d reused, %d GET / answered 304\n", newConns.Load(), reusedConns.Load(), notModified.Load())
+
+	for _, op := range append(ops, handshakeOp) {
+		for reason, count := range op.errors {
+			fmt.Printf("%s: %d x %s\n", op.name, count, reason)
+		}
+	}
+}
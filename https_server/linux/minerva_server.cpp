@@ -0,0 +1,793 @@
+// Linux front end of Minerva.h, serves the same handlers and wire formats as the ESP32 sketches
+// with one epoll loop per thread, every thread accepts on its own SO_REUSEPORT socket and runs TLS with OpenSSL
+//
+//     g++ -O2 -std=c++17 -pthread minerva_server.cpp -lssl -lcrypto -o minerva_server
+//     ./minerva_server [port, default 443] [threads, default one per core]
+//
+// cert.pem and key.pem are loaded from the working directory like server.go does, the login is set below like in the sketch.
+// /metrics and /settings/tls/rotate are device only.
+#define LOGIN_USER "login"
+#define LOGIN_KEY  "d404559f602eab6fd602ac7680dacbfaadd13630335e951f097af3900e9de176b6db28512f2e000b9d04fba5133e8b1c6e8df59db3a8ab9d60be4b97cc9e81db"
+
+#include "../Minerva.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr size_t maxHeaderSize = 8 * 1024;
+constexpr size_t maxBodySize = 64 * 1024;   // ~1500 text fixes in one POST /batch
+constexpr uint32_t idleTimeoutMs = 60000;   // connections without a request for that long are closed
+constexpr int maxEvents = 256;
+
+// The Minerva handlers aren't thread safe, every call into them holds this. The lock-free ones
+// (Minerva::IsLockFree) only need it for Authenticate, held requests are checked without it.
+std::mutex minervaMutex;
+
+
+struct Header
+{
+    std::string name;
+    std::string value;
+};
+
+struct HttpRequest
+{
+    std::string method;
+    std::string path;
+    std::vector<Header> query; // decoded
+    std::vector<Header> headers;
+    std::string body;
+    bool keepAlive;
+};
+
+enum class Parsed { Incomplete, Complete, Invalid };
+
+
+std::string Decode(const std::string& text)
+{
+    // %XX and + of a query string
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '+')
+            decoded += ' ';
+        else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2]))
+        {
+            decoded += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        }
+        else
+            decoded += text[i];
+    }
+    return decoded;
+}
+
+
+std::string Base64Decode(const std::string& text)
+{
+    std::string decoded;
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text)
+    {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '+') v = 62;
+        else if (c == '/') v = 63;
+        else break; // '=' or garbage ends it
+        bits = (bits << 6) | (uint32_t)v;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            decoded += (char)((bits >> count) & 0xff);
+        }
+    }
+    return decoded;
+}
+
+
+const std::string* FindHeader(const std::vector<Header>& headers, const char* name)
+{
+    for (const Header& header : headers)
+    {
+        if (strcasecmp(header.name.c_str(), name) == 0)
+            return &header.value;
+    }
+    return nullptr;
+}
+
+
+// One request from the start of in, consumed is its size with the body. HTTP/1.1 without chunked bodies,
+// the tracker and the app always send a Content-Length.
+Parsed Parse(const std::string& in, HttpRequest& req, size_t& consumed)
+{
+    const size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos)
+        return in.size() > maxHeaderSize ? Parsed::Invalid : Parsed::Incomplete;
+    if (end > maxHeaderSize)
+        return Parsed::Invalid;
+
+    // "METHOD /path?query HTTP/1.1"
+    size_t lineEnd = in.find("\r\n");
+    const std::string line = in.substr(0, lineEnd);
+    const size_t space1 = line.find(' ');
+    const size_t space2 = line.rfind(' ');
+    if (space1 == std::string::npos || space1 == space2)
+        return Parsed::Invalid;
+    req.method = line.substr(0, space1);
+    const std::string target = line.substr(space1 + 1, space2 - space1 - 1);
+    const std::string version = line.substr(space2 + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0")
+        return Parsed::Invalid;
+
+    const size_t question = target.find('?');
+    req.path = Decode(target.substr(0, question));
+    req.query.clear();
+    for (size_t start = question; start != std::string::npos && start < target.size();)
+    {
+        const size_t next = target.find('&', start + 1);
+        const std::string pair = target.substr(start + 1, next == std::string::npos ? std::string::npos : next - start - 1);
+        const size_t equals = pair.find('=');
+        if (!pair.empty())
+            req.query.push_back({ Decode(pair.substr(0, equals)), equals == std::string::npos ? "" : Decode(pair.substr(equals + 1)) });
+        start = next;
+    }
+
+    req.headers.clear();
+    while (lineEnd < end)
+    {
+        const size_t start = lineEnd + 2;
+        lineEnd = in.find("\r\n", start);
+        const size_t colon = in.find(':', start);
+        if (colon == std::string::npos || colon > lineEnd)
+            return Parsed::Invalid;
+        size_t valueStart = colon + 1;
+        while (valueStart < lineEnd && (in[valueStart] == ' ' || in[valueStart] == '\t'))
+            ++valueStart;
+        size_t valueEnd = lineEnd;
+        while (valueEnd > valueStart && (in[valueEnd - 1] == ' ' || in[valueEnd - 1] == '\t'))
+            --valueEnd;
+        req.headers.push_back({ in.substr(start, colon - start), in.substr(valueStart, valueEnd - valueStart) });
+    }
+
+    if (FindHeader(req.headers, "Transfer-Encoding") != nullptr)
+        return Parsed::Invalid;
+    const std::string* length = FindHeader(req.headers, "Content-Length");
+    char* lengthEnd = nullptr;
+    const unsigned long bodySize = length == nullptr ? 0 : strtoul(length->c_str(), &lengthEnd, 10);
+    if (length != nullptr && (lengthEnd == length->c_str() || *lengthEnd != 0))
+        return Parsed::Invalid;
+    if (bodySize > maxBodySize)
+        return Parsed::Invalid;
+    if (in.size() < end + 4 + bodySize)
+        return Parsed::Incomplete;
+    req.body = in.substr(end + 4, bodySize);
+    consumed = end + 4 + bodySize;
+
+    const std::string* connection = FindHeader(req.headers, "Connection");
+    if (version == "HTTP/1.1")
+        req.keepAlive = connection == nullptr || strcasecmp(connection->c_str(), "close") != 0;
+    else
+        req.keepAlive = connection != nullptr && strcasecmp(connection->c_str(), "keep-alive") == 0;
+    return Parsed::Complete;
+}
+
+
+struct Hold;
+
+struct Connection
+{
+    int fd;
+    SSL* ssl;
+    uint32_t ip;
+    uint32_t lastActive;
+    bool handshakeDone = false;
+    bool watchingWrite = false;
+    bool closeAfterWrite = false;
+    bool peerClosed = false;      // close_notify came, what's buffered is still answered
+    std::string in;               // received and not handled yet
+    std::string out;              // response bytes not sent yet
+    size_t outOffset = 0;
+    std::unique_ptr<Hold> hold;   // the request that is held, the ones after it wait in in
+};
+
+
+class LinuxResponse : public Minerva::Response
+{
+public:
+    void SetStatusCode(uint16_t code) override { m_Code = code; }
+    void SetStatusText(const std::string& text) override { m_Text = text; }
+    void SetHeader(const std::string& name, const std::string& value) override
+    {
+        if (strcasecmp(name.c_str(), "Connection") == 0)
+            m_Close = strcasecmp(value.c_str(), "close") == 0;
+        else
+            m_Headers.push_back({ name, value });
+    }
+    void Write(const uint8_t* data, size_t size) override { m_Body.append((const char*)data, size); }
+
+    // like esp32_https_server the status text stays "OK" for the Minerva status codes unless it's set
+    void AppendTo(std::string& out, bool keepAlive) const
+    {
+        char line[64];
+        snprintf(line, sizeof(line), "HTTP/1.1 %u %s\r\n", (unsigned)m_Code, m_Text.c_str());
+        out += line;
+        for (const Header& header : m_Headers)
+            out += header.name + ": " + header.value + "\r\n";
+        out += "Content-Length: " + std::to_string(m_Body.size()) + "\r\n";
+        out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        out += m_Body;
+    }
+
+    bool Close() const { return m_Close; }
+private:
+    uint16_t m_Code = 200;
+    std::string m_Text = "OK";
+    std::vector<Header> m_Headers;
+    std::string m_Body;
+    bool m_Close = false;
+};
+
+
+// a request held by Minerva::Request::Hold, its response is written once changed() or the timeout ends it
+struct Hold
+{
+    std::function<bool()> changed;
+    std::function<void(Minerva::Response&)> respond;
+    std::string id;   // of the tracker changed() looks at
+    uint32_t changes; // of that tracker before changed() was false the last time
+    uint32_t start;
+    unsigned long timeoutMs;
+    LinuxResponse response;
+    bool keepAlive;
+};
+
+
+class LinuxRequest : public Minerva::Request
+{
+public:
+    LinuxRequest(const HttpRequest& req, Connection& connection)
+        : m_Req(req), m_Connection(connection)
+    {
+        const std::string* authorization = FindHeader(req.headers, "Authorization");
+        if (authorization != nullptr && authorization->compare(0, 6, "Basic ") == 0)
+        {
+            const std::string credentials = Base64Decode(authorization->substr(6));
+            const size_t colon = credentials.find(':');
+            m_User = credentials.substr(0, colon);
+            if (colon != std::string::npos)
+                m_Password = credentials.substr(colon + 1);
+        }
+    }
+
+    std::string GetHeader(const std::string& name) override
+    {
+        const std::string* value = FindHeader(m_Req.headers, name.c_str());
+        return value == nullptr ? "" : *value;
+    }
+    bool GetQueryParameter(const std::string& name, std::string& value) override
+    {
+        for (const Header& parameter : m_Req.query)
+        {
+            if (parameter.name == name)
+            {
+                value = parameter.value;
+                return true;
+            }
+        }
+        return false;
+    }
+    std::string GetBasicAuthUser() override { return m_User; }
+    std::string GetBasicAuthPassword() override { return m_Password; }
+    uint32_t GetClientIP() override { return m_Connection.ip; }
+
+    size_t ReadBytes(uint8_t* buffer, size_t size) override
+    {
+        size = std::min(size, m_Req.body.size() - m_Pos);
+        memcpy(buffer, m_Req.body.data() + m_Pos, size);
+        m_Pos += size;
+        return size;
+    }
+    bool RequestComplete() override { return m_Pos >= m_Req.body.size(); }
+    void DiscardRequestBody() override { m_Pos = m_Req.body.size(); }
+
+    // the worker keeps the request and answers it from its loop once the handler returned, HandleOne() sets id and changes
+    void Hold(std::function<bool()> changed, unsigned long timeoutMs, std::function<void(Minerva::Response&)> respond) override
+    {
+        m_Hold.reset(new ::Hold());
+        m_Hold->changed = std::move(changed);
+        m_Hold->respond = std::move(respond);
+        m_Hold->start = Minerva::Millis();
+        m_Hold->timeoutMs = timeoutMs;
+    }
+    std::unique_ptr<::Hold> TakeHold() { return std::move(m_Hold); }
+private:
+    const HttpRequest& m_Req;
+    Connection& m_Connection;
+    std::unique_ptr<::Hold> m_Hold;
+    std::string m_User;
+    std::string m_Password;
+    size_t m_Pos = 0;
+};
+
+
+struct Route
+{
+    const char* method;
+    const char* path;
+    void (*handler)(Minerva::Request&, Minerva::Response&);
+};
+
+// the nodes of the sketch, everything else goes to Handle404
+const Route routes[] =
+{
+    { "GET", "/", Minerva::HandleGet },
+    { "POST", "/", Minerva::HandlePost },
+    { "POST", "/batch", Minerva::HandlePostBatch },
+    { "GET", "/history", Minerva::HandleGetHistory },
+    { "GET", "/devices", Minerva::HandleGetDevices },
+    { "GET", "/settings/tracker/status", Minerva::HandleGetTrackerSettingsStatus },
+    { "GET", "/settings/tracker/applied", Minerva::HandleGetTrackerSettingsApplied },
+    { "GET", "/settings/tracker", Minerva::HandleGetTrackerSettings },
+    { "POST", "/settings/tracker", Minerva::HandlePostTrackerSettings },
+    { "POST", "/login", Minerva::HandlePostLogin },
+};
+
+
+// An epoll loop with its own listening socket, the kernel spreads new connections over the workers.
+// A long-poll is kept with the held connections of its worker under the id of its tracker. A request that
+// changes a tracker passes the id to the workers with requests held for it and wakes them through their
+// eventfd, they only check those requests again. The rest is only looked at once its timeout runs out.
+class Worker
+{
+public:
+    Worker(SSL_CTX* context, int port, const std::vector<std::unique_ptr<Worker>>& workers)
+        : m_Context(context), m_Workers(workers)
+    {
+        m_Listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        const int one = 1;
+        setsockopt(m_Listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(m_Listen, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons((uint16_t)port);
+        if (m_Listen < 0 || bind(m_Listen, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_Listen, SOMAXCONN) != 0)
+        {
+            perror("listen");
+            exit(1);
+        }
+
+        m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_Wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        for (int fd : { m_Listen, m_Wake })
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    void Run()
+    {
+        for (;;)
+        {
+            Poll(NextTimeoutMs());
+            CheckHolds();
+        }
+    }
+private:
+    void Poll(int timeoutMs)
+    {
+        epoll_event events[maxEvents];
+        const int count = epoll_wait(m_Epoll, events, maxEvents, timeoutMs);
+        for (int i = 0; i < count; ++i)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == m_Listen)
+            {
+                Accept();
+                continue;
+            }
+            if (fd == m_Wake)
+            {
+                uint64_t wakes;
+                (void)!read(m_Wake, &wakes, sizeof(wakes)); // CheckHolds() picks up m_Changed next
+                continue;
+            }
+            auto it = m_Connections.find(fd);
+            if (it != m_Connections.end() && !Advance(*it->second))
+                Close(fd);
+        }
+
+        const uint32_t now = Minerva::Millis();
+        if (now - m_LastIdleCheck >= 1000)
+        {
+            m_LastIdleCheck = now;
+            std::vector<int> idle;
+            for (const auto& entry : m_Connections)
+            {
+                if (!entry.second->hold && now - entry.second->lastActive >= idleTimeoutMs)
+                    idle.push_back(entry.first);
+            }
+            for (int fd : idle)
+                Close(fd);
+        }
+    }
+
+    // how long epoll_wait may block, until the first held request runs out of time or the idle check
+    int NextTimeoutMs() const
+    {
+        if (m_Held.empty())
+            return 1000;
+        const int32_t left = (int32_t)(m_NextTimeout - Minerva::Millis());
+        return std::max(0, std::min(1000, (int)left));
+    }
+
+    // answers the held requests whose tracker changed or that ran out of time
+    void CheckHolds()
+    {
+        std::vector<std::string> changed;
+        {
+            std::lock_guard<std::mutex> lock(m_HeldMutex);
+            changed.swap(m_Changed);
+        }
+        std::vector<int> check;
+        for (const std::string& id : changed)
+        {
+            auto it = m_Held.find(id);
+            if (it != m_Held.end())
+                check.insert(check.end(), it->second.begin(), it->second.end());
+        }
+        const uint32_t now = Minerva::Millis();
+        if (!m_Held.empty() && (int32_t)(now - m_NextTimeout) >= 0)
+        {
+            m_NextTimeout = now + 1000;
+            for (const auto& entry : m_Held)
+            {
+                for (int fd : entry.second)
+                {
+                    const Hold& hold = *m_Connections[fd]->hold;
+                    const uint32_t end = hold.start + (uint32_t)hold.timeoutMs;
+                    if ((int32_t)(now - end) >= 0)
+                        check.push_back(fd);
+                    else if ((int32_t)(end - m_NextTimeout) < 0)
+                        m_NextTimeout = end;
+                }
+            }
+        }
+        if (check.empty())
+            return;
+        std::sort(check.begin(), check.end());
+        check.erase(std::unique(check.begin(), check.end()), check.end());
+
+        // changed() and respond() only read seqlocks, no minervaMutex
+        std::vector<int> done;
+        for (int fd : check)
+        {
+            Hold& hold = *m_Connections[fd]->hold;
+            const uint32_t changes = Minerva::ReadDevice(hold.id).changes.load(std::memory_order_acquire);
+            if ((changes != hold.changes && hold.changed()) || now - hold.start >= hold.timeoutMs)
+            {
+                hold.respond(hold.response);
+                done.push_back(fd);
+            }
+            else
+                hold.changes = changes; // e.g. the settings of a tracker whose GET / waits for a fix
+        }
+
+        for (int fd : done)
+        {
+            Connection& connection = *m_Connections[fd];
+            Unhold(connection);
+            std::unique_ptr<Hold> hold = std::move(connection.hold);
+            Respond(connection, hold->response, hold->keepAlive);
+            if (!Advance(connection)) // sends it and handles what was pipelined behind it
+                Close(fd);
+        }
+    }
+
+    void AddHold(const Connection& connection)
+    {
+        const Hold& hold = *connection.hold;
+        const uint32_t end = hold.start + (uint32_t)hold.timeoutMs;
+        if (m_Held.empty() || (int32_t)(end - m_NextTimeout) < 0)
+            m_NextTimeout = end;
+        std::lock_guard<std::mutex> lock(m_HeldMutex);
+        m_Held[hold.id].push_back(connection.fd);
+        // The handler ran without minervaMutex, a change since it started may have been passed to Notify() before
+        // the request was in m_Held. Every change after this sees it there.
+        if (Minerva::ReadDevice(hold.id).changes.load(std::memory_order_acquire) != hold.changes)
+        {
+            if (std::find(m_Changed.begin(), m_Changed.end(), hold.id) == m_Changed.end())
+                m_Changed.push_back(hold.id);
+            const uint64_t one = 1;
+            (void)!write(m_Wake, &one, sizeof(one));
+        }
+    }
+
+    void Unhold(const Connection& connection)
+    {
+        std::lock_guard<std::mutex> lock(m_HeldMutex);
+        auto it = m_Held.find(connection.hold->id);
+        it->second.erase(std::find(it->second.begin(), it->second.end(), connection.fd));
+        if (it->second.empty())
+            m_Held.erase(it);
+    }
+
+    // a handled request changed the tracker id, the requests held for it may be waiting for that
+    void Notify(const std::string& id)
+    {
+        for (const std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            std::lock_guard<std::mutex> lock(worker->m_HeldMutex);
+            if (worker->m_Held.count(id) == 0)
+                continue;
+            if (std::find(worker->m_Changed.begin(), worker->m_Changed.end(), id) == worker->m_Changed.end())
+                worker->m_Changed.push_back(id);
+            const uint64_t one = 1;
+            (void)!write(worker->m_Wake, &one, sizeof(one));
+        }
+    }
+
+    void Accept()
+    {
+        for (;;)
+        {
+            sockaddr_in address = {};
+            socklen_t size = sizeof(address);
+            const int fd = accept4(m_Listen, (sockaddr*)&address, &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return; // EAGAIN, or out of fds and the client is retried on the next event
+
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            std::unique_ptr<Connection> connection(new Connection());
+            connection->fd = fd;
+            connection->ssl = SSL_new(m_Context);
+            connection->ip = address.sin_addr.s_addr;
+            connection->lastActive = Minerva::Millis();
+            SSL_set_fd(connection->ssl, fd);
+            SSL_set_accept_state(connection->ssl);
+
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+            m_Connections[fd] = std::move(connection);
+        }
+    }
+
+    void Close(int fd)
+    {
+        auto it = m_Connections.find(fd);
+        if (it->second->hold)
+            Unhold(*it->second);
+        SSL_free(it->second->ssl);
+        close(fd); // also removes it from epoll
+        m_Connections.erase(it);
+    }
+
+    void Watch(Connection& connection, bool write)
+    {
+        if (connection.watchingWrite == write)
+            return;
+        connection.watchingWrite = write;
+        epoll_event event = {};
+        event.events = write ? EPOLLOUT : EPOLLIN;
+        event.data.fd = connection.fd;
+        epoll_ctl(m_Epoll, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    // false if the connection is done and has to be closed
+    bool Advance(Connection& connection)
+    {
+        if (!connection.handshakeDone)
+        {
+            const int result = SSL_do_handshake(connection.ssl);
+            if (result != 1)
+            {
+                const int error = SSL_get_error(connection.ssl, result);
+                if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE)
+                    return false;
+                Watch(connection, error == SSL_ERROR_WANT_WRITE);
+                return true;
+            }
+            connection.handshakeDone = true;
+        }
+
+        // one request at a time, the previous response is sent before the next pipelined request is handled
+        for (;;)
+        {
+            if (!Flush(connection))
+                return false;
+            if (connection.outOffset < connection.out.size())
+            {
+                Watch(connection, true);
+                return true;
+            }
+            if (connection.closeAfterWrite || !Read(connection))
+                return false;
+            if (connection.hold)
+            {
+                // still read so a hangup closes it, a client that keeps sending isn't waited for
+                if (connection.peerClosed || connection.in.size() > maxHeaderSize + maxBodySize)
+                    return false;
+                Watch(connection, false);
+                return true;
+            }
+            if (!HandleOne(connection))
+            {
+                if (connection.peerClosed)
+                    return false;
+                Watch(connection, false);
+                return true;
+            }
+        }
+    }
+
+    bool Flush(Connection& connection)
+    {
+        while (connection.outOffset < connection.out.size())
+        {
+            const int sent = SSL_write(connection.ssl, connection.out.data() + connection.outOffset, (int)(connection.out.size() - connection.outOffset));
+            if (sent <= 0)
+            {
+                const int error = SSL_get_error(connection.ssl, sent);
+                return error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ;
+            }
+            connection.outOffset += sent;
+        }
+        connection.out.clear();
+        connection.outOffset = 0;
+        return true;
+    }
+
+    bool Read(Connection& connection)
+    {
+        char buffer[16 * 1024];
+        while (!connection.peerClosed && connection.in.size() <= maxHeaderSize + maxBodySize) // beyond that Parse() rejects it anyway
+        {
+            const int size = SSL_read(connection.ssl, buffer, sizeof(buffer));
+            if (size <= 0)
+            {
+                const int error = SSL_get_error(connection.ssl, size);
+                connection.peerClosed = error == SSL_ERROR_ZERO_RETURN;
+                return connection.peerClosed || error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE;
+            }
+            connection.in.append(buffer, size);
+            connection.lastActive = Minerva::Millis();
+        }
+        return true;
+    }
+
+    // false if there is no complete request yet
+    bool HandleOne(Connection& connection)
+    {
+        HttpRequest request;
+        size_t consumed = 0;
+        const Parsed parsed = Parse(connection.in, request, consumed);
+        if (parsed == Parsed::Incomplete)
+            return false;
+        if (parsed == Parsed::Invalid)
+        {
+            connection.out += "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            connection.closeAfterWrite = true;
+            return true;
+        }
+        connection.in.erase(0, consumed);
+
+        void (*handler)(Minerva::Request&, Minerva::Response&) = Minerva::Handle404;
+        for (const Route& route : routes)
+        {
+            if (request.method == route.method && request.path == route.path)
+                handler = route.handler;
+        }
+
+        LinuxResponse response;
+        LinuxRequest req(request, connection);
+        const std::string id = Minerva::DeviceId(req);
+        // read before the handler reads anything of the tracker, a hold compares against it
+        const uint32_t changes = Minerva::ReadDevice(id).changes.load(std::memory_order_acquire);
+        const bool lockFree = Minerva::IsLockFree(handler);
+        bool authorized = false;
+        {
+            std::lock_guard<std::mutex> lock(minervaMutex);
+            if (lockFree)
+                Minerva::Authenticate(req, response, [&] { authorized = true; });
+            else
+                Minerva::Authenticate(req, response, [&] { handler(req, response); });
+        }
+        if (authorized)
+            handler(req, response);
+
+        connection.hold = req.TakeHold();
+        if (connection.hold)
+        {
+            connection.hold->id = id;
+            connection.hold->changes = changes;
+            connection.hold->response = std::move(response);
+            connection.hold->keepAlive = request.keepAlive;
+            AddHold(connection);
+            return true;
+        }
+        Respond(connection, response, request.keepAlive);
+        if (!lockFree && Minerva::ReadDevice(id).changes.load(std::memory_order_acquire) != changes)
+            Notify(id);
+        return true;
+    }
+
+    void Respond(Connection& connection, const LinuxResponse& response, bool keepAliveRequested)
+    {
+        const bool keepAlive = keepAliveRequested && !response.Close();
+        response.AppendTo(connection.out, keepAlive);
+        connection.closeAfterWrite = !keepAlive;
+        connection.lastActive = Minerva::Millis();
+    }
+private:
+    SSL_CTX* m_Context;
+    const std::vector<std::unique_ptr<Worker>>& m_Workers;
+    int m_Listen = -1;
+    int m_Epoll = -1;
+    int m_Wake = -1; // eventfd
+    std::unordered_map<int, std::unique_ptr<Connection>> m_Connections;
+    // Connections with a held request by the id of its tracker. Only this worker changes it, the others read it in
+    // Notify() and add the ids they changed to m_Changed, both under m_HeldMutex.
+    std::unordered_map<std::string, std::vector<int>> m_Held;
+    std::vector<std::string> m_Changed;
+    std::mutex m_HeldMutex;
+    uint32_t m_NextTimeout = 0; // Millis() when the first held request runs out of time, or earlier
+    uint32_t m_LastIdleCheck = 0;
+};
+
+
+int main(int argc, char** argv)
+{
+    const int port = argc > 1 ? atoi(argv[1]) : 443;
+    const unsigned threads = argc > 2 ? (unsigned)atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    signal(SIGPIPE, SIG_IGN);
+    if (!Minerva::Begin(LOGIN_USER, LOGIN_KEY))
+        fprintf(stderr, "LOGIN_KEY is not a sha512 hex string, every login will fail\n");
+
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    // responses are appended to the buffer while a write of it is pending
+    SSL_CTX_set_mode(context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (SSL_CTX_use_certificate_chain_file(context, "cert.pem") != 1 || SSL_CTX_use_PrivateKey_file(context, "key.pem", SSL_FILETYPE_PEM) != 1)
+    {
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+
+    // all workers exist before the first one runs, they wake each other
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back(new Worker(context, port, workers));
+    std::vector<std::thread> runs;
+    for (const std::unique_ptr<Worker>& worker : workers)
+        runs.emplace_back([&worker] { worker->Run(); });
+    printf("Listening on port %d with %u threads\n", port, threads);
+    for (std::thread& run : runs)
+        run.join();
+    return 0;
+}
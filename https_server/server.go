@@ -9,6 +9,8 @@ import (
 	"log"
 	"math/rand"
 	"net/http"
+	"sort"
+	"sync"
 	"time"
 )
 
@@ -23,11 +25,23 @@ const (
     StatusSettingsApplied = 203
 )
 
-var (
+// Every tracker gets an entry on its first upload or settings change. Requests pick it with "?id=<tracker id>",
+// without an id they go to the "" tracker so a single tracker works as before.
+const (
+	MaxDevices   = 48 // same limit as maxDevices of Minerva.h
+	DeviceIdSize = 16
+)
+
+type Device struct {
 	data            []byte
 	settingsData    []byte
 	settingsChanged bool
 	lastSignal      time.Time
+}
+
+var (
+	devicesMutex sync.Mutex
+	devices      = make(map[string]*Device, MaxDevices)
 )
 
 func main() {
@@ -40,6 +54,7 @@ func main() {
 	http.HandleFunc("/settings/tracker/status", HandleSettingsTrackerStatus)
 	http.HandleFunc("/settings/tracker/applied", HandleSettingsTrackerApplied)
 	http.HandleFunc("/settings/tracker", HandleSettingsTracker)
+	http.HandleFunc("/devices", HandleDevices)
 	http.HandleFunc("/", Handle404)
 
 	server := &http.Server{
@@ -74,14 +89,45 @@ func Authenticate(r *http.Request) bool {
 }
 
 
+// IsValidDeviceId reports whether id can be listed by /devices, separators and control characters would break its lines
+func IsValidDeviceId(id string) bool {
+	for i := 0; i < len(id); i++ {
+		if id[i] == ',' || id[i] < 0x20 || id[i] == 0x7f {
+			return false
+		}
+	}
+	return true
+}
+
+// GetDevice returns the tracker of the request, it's created if create is set and there is room left.
+// Unknown trackers read as one that never sent anything. devicesMutex has to be locked.
+func GetDevice(r *http.Request, create bool) *Device {
+	id := r.URL.Query().Get("id")
+	if device, ok := devices[id]; ok {
+		return device
+	}
+	if !create || len(id) > DeviceIdSize || !IsValidDeviceId(id) || len(devices) >= MaxDevices {
+		return nil
+	}
+	device := &Device{}
+	devices[id] = device
+	return device
+}
+
 func HandleInfo(w http.ResponseWriter, r *http.Request) {
 	if !Authenticate(r) {
 		return
 	}
 
 	if r.Method == http.MethodGet {
+		devicesMutex.Lock()
+		defer devicesMutex.Unlock()
+		device := GetDevice(r, false)
+		if device == nil {
+			device = &Device{}
+		}
 		w.Header().Add("Content-Type", "text/plain")
-		fmt.Fprintf(w, "%d,%s", time.Now().Sub(lastSignal).Milliseconds(), data)
+		fmt.Fprintf(w, "%d,%s", time.Now().Sub(device.lastSignal).Milliseconds(), device.data)
 	} else if r.Method == http.MethodPost {
 		body, err := io.ReadAll(r.Body)
 		defer r.Body.Close()
@@ -89,9 +135,17 @@ func HandleInfo(w http.ResponseWriter, r *http.Request) {
 			fmt.Println("Failed to read body")
 			return
 		}
-		data = body
-		lastSignal = time.Now()
-		if settingsChanged {
+
+		devicesMutex.Lock()
+		defer devicesMutex.Unlock()
+		device := GetDevice(r, true)
+		if device == nil {
+			w.WriteHeader(http.StatusNoContent)
+			return
+		}
+		device.data = body
+		device.lastSignal = time.Now()
+		if device.settingsChanged {
 			w.WriteHeader(StatusSettingsChanged)
 		}
 	}
@@ -103,8 +157,12 @@ func HandleSettingsTracker(w http.ResponseWriter, r *http.Request) {
 	}
 
 	if r.Method == http.MethodGet {
+		devicesMutex.Lock()
+		defer devicesMutex.Unlock()
 		w.Header().Add("Content-Type", "text/plain")
-		fmt.Fprintf(w, "%s", settingsData)
+		if device := GetDevice(r, false); device != nil {
+			fmt.Fprintf(w, "%s", device.settingsData)
+		}
 	} else if r.Method == http.MethodPost {
 		body, err := io.ReadAll(r.Body)
 		defer r.Body.Close()
@@ -112,8 +170,16 @@ func HandleSettingsTracker(w http.ResponseWriter, r *http.Request) {
 			fmt.Println("Failed to read settings body")
 			return
 		}
-		settingsData = body
-		settingsChanged = true
+
+		devicesMutex.Lock()
+		defer devicesMutex.Unlock()
+		device := GetDevice(r, true)
+		if device == nil {
+			w.WriteHeader(http.StatusNoContent)
+			return
+		}
+		device.settingsData = body
+		device.settingsChanged = true
 	}
 }
 
@@ -122,7 +188,11 @@ func HandleSettingsTrackerApplied(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	settingsChanged = false
+	devicesMutex.Lock()
+	defer devicesMutex.Unlock()
+	if device := GetDevice(r, false); device != nil {
+		device.settingsChanged = false
+	}
 }
 
 func HandleSettingsTrackerStatus(w http.ResponseWriter, r *http.Request) {
@@ -130,13 +200,45 @@ func HandleSettingsTrackerStatus(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	if settingsChanged {
+	devicesMutex.Lock()
+	defer devicesMutex.Unlock()
+	if device := GetDevice(r, false); device != nil && device.settingsChanged {
 		w.WriteHeader(StatusSettingsPending)
 	} else {
 		w.WriteHeader(StatusSettingsApplied)
 	}
 }
 
+// HandleDevices lists the trackers as "id,age,status\n", age is the time since the last fix in ms,
+// empty if there was none
+func HandleDevices(w http.ResponseWriter, r *http.Request) {
+	if !Authenticate(r) {
+		return
+	}
+
+	devicesMutex.Lock()
+	defer devicesMutex.Unlock()
+	ids := make([]string, 0, len(devices))
+	for id := range devices {
+		ids = append(ids, id)
+	}
+	sort.Strings(ids)
+
+	w.Header().Add("Content-Type", "text/plain")
+	for _, id := range ids {
+		device := devices[id]
+		status := StatusSettingsApplied
+		if device.settingsChanged {
+			status = StatusSettingsPending
+		}
+		if device.lastSignal.IsZero() {
+			fmt.Fprintf(w, "%s,,%d\n", id, status)
+		} else {
+			fmt.Fprintf(w, "%s,%d,%d\n", id, time.Now().Sub(device.lastSignal).Milliseconds(), status)
+		}
+	}
+}
+
 func Handle404(w http.ResponseWriter, r *http.Request) {
 	if !Authenticate(r) {
 		return
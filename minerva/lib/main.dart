@@ -88,6 +88,7 @@ class _HomeState extends State<Home>
   static int _Speed = 0;
   static int _TimeSinceLastTrackerSignal = 0;
   static int _TimeSinceLastServerUpdate = 0;
+  static String? _ETag; // of the last response, the server answers with an empty 304 until there is a new fix
   final Stopwatch _Stopwatch = Stopwatch()..start();
 
   Future<void> _OpenMapMobile(double latitude, double longitude) async
@@ -212,6 +213,17 @@ class _HomeState extends State<Home>
 
   void _ParseBody(http.Response response)
   {
+    if (response.statusCode == 304)
+    {
+      // same fix as last time, only the time since it was received went on
+      int tmp = _Stopwatch.elapsedMilliseconds;
+      _TimeSinceLastTrackerSignal += tmp;
+      _TimeSinceLastServerUpdate = tmp;
+      _Stopwatch.reset();
+      return;
+    }
+    _ETag = response.headers["etag"];
+
     List<String> split = response.body.split(",");
     if (split.length != 5)
     {
@@ -264,7 +276,11 @@ class _HomeState extends State<Home>
         Pw: 1234
     */
 
-    http.get(Uri.parse('https://${Settings.serverIp}'), headers: {"authorization": 'Basic ${base64.encode(ascii.encode(Settings.serverAuth))}'}).then(_ParseBody).catchError((e){_ShowError(context, "Failed to get information: ${e.toString()}");});
+    Settings.Send((headers)
+    {
+      if (_ETag != null) headers["if-none-match"] = _ETag!;
+      return Settings.client.get(Uri.parse('https://${Settings.serverIp}'), headers: headers);
+    }).then(_ParseBody).catchError((e){_ShowError(context, "Failed to get information: ${e.toString()}");});
   }
 
 
@@ -515,7 +531,7 @@ class Settings
   {
     try
     {
-      await http.post(Uri.parse('https://${Settings.serverIp}/settings/tracker'), headers: {"authorization": 'Basic ${base64.encode(ascii.encode(Settings.serverAuth))}'}, body: _BuildTrackerBody());
+      await Settings.Send((headers) => Settings.client.post(Uri.parse('https://${Settings.serverIp}/settings/tracker'), headers: headers, body: _BuildTrackerBody()));
       updateTracker = false;
       trackerApproved = false;
     }
@@ -528,6 +544,37 @@ class Settings
   // server settings
   static String serverIp = "192.168.178.90";
   static String serverAuth = "login:1234";
+  // one client for all requests so the TLS connection to the server is kept alive and reused
+  // instead of doing a full handshake on every poll, the server only keeps it open if asked to
+  static final http.Client client = http.Client();
+  static Map<String, String> get _BasicHeaders => {"authorization": 'Basic ${base64.encode(ascii.encode(serverAuth))}', "connection": "keep-alive"};
+  // of POST /login, the server checks it without hashing the password on every request, null sends the password
+  static String? _SessionToken;
+  static bool _NoSessions = false; // the server answered /login without a token, e.g. the Go server
+  static Map<String, String> get serverHeaders => _SessionToken == null ? _BasicHeaders : {"authorization": 'Bearer $_SessionToken', "connection": "keep-alive"};
+
+  static Future<void> Login() async
+  {
+    // "token,lifetime_ms", a server without sessions keeps getting the password
+    final response = await client.post(Uri.parse('https://$serverIp/login'), headers: _BasicHeaders);
+    final List<String> split = response.body.split(",");
+    _SessionToken = response.statusCode == 200 && split.length == 2 && split[0].length == 32 ? split[0] : null;
+    _NoSessions = _SessionToken == null;
+  }
+
+  // Sends a request built by request with the headers to use, logs in first and again if the server answers 401
+  // because the token expired or the server restarted
+  static Future<http.Response> Send(Future<http.Response> Function(Map<String, String> headers) request) async
+  {
+    if (_SessionToken == null && !_NoSessions) await Login();
+    http.Response response = await request(serverHeaders);
+    if (response.statusCode == 401)
+    {
+      await Login();
+      response = await request(serverHeaders);
+    }
+    return response;
+  }
 
 
   static T _GetSetting<T>(T? ret, T defaultValue)
@@ -848,7 +895,7 @@ class _SettingsPageState extends State<SettingsPage>
   }
 
 
-  Timer? _RequestTimer;
+  bool _Disposed = false;
   @override
   void initState()
   {
@@ -857,30 +904,36 @@ class _SettingsPageState extends State<SettingsPage>
 
   Future<void> _MakeRequest() async
   {
-    http.get(Uri.parse('https://${Settings.serverIp}/settings/tracker/status'), headers: {"authorization": 'Basic ${base64.encode(ascii.encode(Settings.serverAuth))}'}).then((response) {
-      setState(() {
-        Settings.trackerApproved = response.statusCode == 203;
-      });
-      _RequestTimer?.cancel();
-      _RequestTimer = null;
-    }).catchError((e){_ShowError(context, "Failed to get settings status: ${e.toString()}");});
-
-    _RequestTimer = Timer.periodic(const Duration(seconds: 60), (timer) {
-      http.get(Uri.parse('https://${Settings.serverIp}/settings/tracker/status'), headers: {"authorization": 'Basic ${base64.encode(ascii.encode(Settings.serverAuth))}'}).then((response) {
+    // long-poll, the server holds the request until the status isn't pending (202) anymore or 20 seconds passed
+    const wait = Duration(seconds: 20);
+    while (!_Disposed && !Settings.trackerApproved)
+    {
+      try
+      {
+        final held = Stopwatch()..start();
+        final response = await Settings.Send((headers) => Settings.client.get(Uri.parse('https://${Settings.serverIp}/settings/tracker/status?wait=${wait.inMilliseconds}&status=202'), headers: headers));
+        if (_Disposed) return;
         setState(() {
           Settings.trackerApproved = response.statusCode == 203;
         });
-        _RequestTimer?.cancel();
-        _RequestTimer = null;
-      }).catchError((e){_ShowError(context, "Failed to get settings status: ${e.toString()}");});
-    });
+        // not a status, e.g. rejected login, don't hammer the server
+        if (response.statusCode != 202 && response.statusCode != 203) await Future.delayed(const Duration(seconds: 60));
+        // still pending long before the wait ran out, the server didn't hold the request, ask again once it would have
+        else if (response.statusCode == 202 && held.elapsed < wait ~/ 2) await Future.delayed(wait - held.elapsed);
+      }
+      catch (e)
+      {
+        if (_Disposed) return;
+        _ShowError(context, "Failed to get settings status: ${e.toString()}");
+        await Future.delayed(const Duration(seconds: 60));
+      }
+    }
   }
 
   @override
   void dispose()
   {
-    _RequestTimer?.cancel();
-    _RequestTimer = null;
+    _Disposed = true;
     super.dispose();
   }
 }
@@ -8,6 +8,9 @@
 #define WIFI_SSID "WIFI_NAME"
 #define WIFI_PSK "WIFI_PASSWORD"
 #define SERVER_IP "https://192.168.178.90"
+#define TRACKER_ID "" // tells the server which tracker this is when it serves more than one, max 16 chars
+#define LOGIN_USER "login"
+#define LOGIN_PASSWORD "1234"
 
 enum Status
 {
@@ -15,7 +18,8 @@ enum Status
     SettingsChanged = 201,
     SettingsPending = 202,
     SettingsApplied = 203,
-    Error = 204
+    Error = 204,
+    SessionExpired = 401
 };
 
 static HTTPClient http;
@@ -42,8 +46,34 @@ void setup()
     Serial.print("Connected. IP=");
     Serial.println(WiFi.localIP());
 
-    http.setAuthorization("login", "1234");
-    http.begin(SERVER_IP);
+    // HTTPClient keeps the connection open by default, so the POST, /settings/tracker and /settings/tracker/applied
+    // share one TLS handshake. TLS session resumption isn't implemented, every reconnect does a full handshake.
+    http.begin(SERVER_IP "/?id=" TRACKER_ID);
+    Login();
+}
+
+
+// Trades the password for a session token, the server checks the token without hashing the password on every upload.
+// Without a token, e.g. from a server that has no /login, the password is sent with every request as before.
+void Login()
+{
+    http.setURL("/login");
+    http.setAuthorizationType("Basic");
+    http.setAuthorization(LOGIN_USER, LOGIN_PASSWORD);
+    // "token,lifetime_ms"
+    const int httpResponseCode = http.POST("");
+    const String body = httpResponseCode == Status::Ok ? http.getString() : String();
+    if (body.indexOf(',') == 32)
+    {
+        http.setAuthorizationType("Bearer");
+        http.setAuthorization(body.substring(0, 32).c_str());
+    }
+    else
+    {
+        Serial.print("Login failed: ");
+        Serial.println(httpResponseCode);
+    }
+    http.setURL("/?id=" TRACKER_ID);
 }
 
 
@@ -67,7 +97,7 @@ bool SplitString(const String& str, char c, String* buffer, size_t size)
 
 void ChangeSettings()
 {
-    http.setURL("/settings/tracker");
+    http.setURL("/settings/tracker?id=" TRACKER_ID);
     Serial.print("Applying settings\n");
     if(http.GET() != Status::Ok) return;
     String buffer[4];
@@ -81,9 +111,9 @@ void ChangeSettings()
     Serial.println(sleepForBetweenSamples);
     Serial.println(samplesToCollect);
     Serial.println(sleepForWhileNoSignal);
-    http.setURL("/settings/tracker/applied");
+    http.setURL("/settings/tracker/applied?id=" TRACKER_ID);
     http.GET();
-    http.setURL("/");
+    http.setURL("/?id=" TRACKER_ID);
 }
 
 
@@ -101,6 +131,12 @@ void SendData(double lat, double lng, int alt, int kmh)
     Serial.printf("Buffer: %s\n", buffer.c_str());
 
     int httpResponseCode = http.POST(buffer);
+    if (httpResponseCode == Status::SessionExpired)
+    {
+        // the token ran out or the server restarted
+        Login();
+        httpResponseCode = http.POST(buffer);
+    }
     if (httpResponseCode == Status::SettingsChanged)
     {
         ChangeSettings();